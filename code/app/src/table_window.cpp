@@ -14,6 +14,39 @@
 
 namespace FinanceManager {
 
+namespace {
+
+// Split one CSV record, honouring RFC 4180 quoting ("a,b" and "" inside quotes)
+QStringList splitCsvLine(const QString& line) {
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        QChar c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.append(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.append(field);
+    return fields;
+}
+
+} // namespace
+
 TableWindow::TableWindow(const QString& title, QWidget* parent)
     : QMainWindow(parent)
     , table(new QTableWidget(this))
@@ -102,7 +135,7 @@ void TableWindow::loadFromCSV(const QString& filePath) {
     int row = 0;
     while (!in.atEnd()) {
         QString line = in.readLine();
-        QStringList fields = line.split(',');
+        QStringList fields = splitCsvLine(line);
         
         table->insertRow(row);
         for (int col = 0; col < fields.size(); ++col) {
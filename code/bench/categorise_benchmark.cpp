@@ -0,0 +1,121 @@
+// Measures TransactionCategorisation throughput at 1, 2, 4, 8 and 16 threads
+// and checks every run against the serial result.
+// Usage: categorise_benchmark [keywords.csv] [rows] [repetitions]
+// Without a keyword file, a synthetic rule set of 500 keywords is used.
+
+#include "keyword_loader.hpp"
+#include "parallel_for.hpp"
+#include "transaction_categorisation.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace finance;
+
+namespace {
+
+std::map<std::string, std::string> syntheticKeywords() {
+    static const char* categories[] = {"Groceries", "Transport", "Shopping", "Bills", "Credit card"};
+    std::map<std::string, std::string> keyword_map;
+    for (int i = 0; i < 500; ++i) {
+        keyword_map["merchant" + std::to_string(i * 7919 % 100000)] = categories[i % 5];
+    }
+    return keyword_map;
+}
+
+// Card-payment style descriptions; about one in four matches no keyword
+std::vector<Expense> syntheticExpenses(const std::map<std::string, std::string>& keyword_map,
+                                       size_t rows) {
+    std::vector<std::string> keywords;
+    for (const auto& [keyword, category] : keyword_map) {
+        std::string upper = keyword;
+        std::transform(upper.begin(), upper.end(), upper.begin(),
+                       [](unsigned char c) { return std::toupper(c); });
+        keywords.push_back(upper);
+    }
+
+    std::vector<Expense> expenses(rows);
+    uint64_t state = 0x9e3779b97f4a7c15;
+    for (size_t i = 0; i < rows; ++i) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        uint64_t pick = state >> 33;
+        std::string description = "CARD PAYMENT TO ";
+        if (pick % 4 == 0) {
+            description += "UNKNOWN SHOP " + std::to_string(pick % 5000);
+        } else {
+            description += keywords[pick % keywords.size()];
+            description += pick % 3 == 0 ? " AMEX REF " : " LONDON REF ";
+            description += std::to_string(pick % 100000);
+        }
+        expenses[i].description = Symbol::intern(description);
+        expenses[i].amount = Money::fromMinor(-static_cast<int64_t>(pick % 100000));
+    }
+    return expenses;
+}
+
+bool sameResult(const std::vector<Expense>& a, const std::vector<Expense>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].category != b[i].category || a[i].amount != b[i].amount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::string> keyword_map;
+    try {
+        keyword_map = argc > 1 ? KeywordLoader(argv[1]).loadKeywords() : syntheticKeywords();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    size_t rows = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    int repetitions = argc > 3 ? std::stoi(argv[3]) : 3;
+
+    TransactionCategorisation categoriser(keyword_map);
+    const std::vector<Expense> input = syntheticExpenses(keyword_map, rows);
+    std::cout << "Input: " << rows << " rows, " << keyword_map.size() << " keywords, "
+              << defaultThreadCount() << " hardware threads\n";
+
+    std::vector<Expense> reference = input;
+    categoriser.categoriseExpenses(reference);
+
+    double serial_seconds = 0.0;
+    for (size_t threads : {1, 2, 4, 8, 16}) {
+        CategorisationStats stats;
+        double best_seconds = 0.0;
+        for (int rep = 0; rep < repetitions; ++rep) {
+            std::vector<Expense> expenses = input;
+            auto start = std::chrono::steady_clock::now();
+            stats = categoriser.categoriseExpenses(expenses, threads);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (rep == 0 || elapsed.count() < best_seconds) {
+                best_seconds = elapsed.count();
+            }
+            if (!sameResult(expenses, reference)) {
+                std::cerr << threads << " threads: result differs from serial run" << std::endl;
+                return 1;
+            }
+        }
+        if (threads == 1) {
+            serial_seconds = best_seconds;
+        }
+
+        std::cout << threads << " threads: " << (rows / best_seconds) / 1e6 << " M rows/s, "
+                  << serial_seconds / best_seconds << "x ("
+                  << stats.matched << " matched, " << stats.uncategorised << " uncategorised, "
+                  << stats.inverted << " inverted)\n";
+    }
+
+    return 0;
+}
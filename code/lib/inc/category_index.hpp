@@ -0,0 +1,85 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include "rule_stats.hpp"
+#include "time_buckets.hpp"
+#include "transaction_categorisation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Categorised expenses kept with an inverted index from the keyword that
+// decided each row (or the uncategorised bucket) to row ids, plus the
+// monthly and weekly totals. Reloading an edited keyword map recategorises
+// only the rows whose outcome can change and patches the totals in place:
+//   - rows decided by a removed or re-categorised keyword
+//   - rows containing an added keyword that are uncategorised, matched on
+//     their name, or decided by a keyword later in map order
+// Maps where a keyword has an empty category fall back to a full pass.
+class CategoryIndex {
+public:
+    struct ReloadStats {
+        size_t keywords_added = 0;
+        size_t keywords_removed = 0;
+        size_t keywords_changed = 0;   // Same keyword, other category
+        size_t rows_checked = 0;       // Rows recategorised
+        size_t rows_changed = 0;       // Rows whose category or sign changed
+    };
+
+    // Categorise expenses as parsed (not yet categorised) and index them,
+    // counting the deciding rules in rule_stats when given (the pass is
+    // timed including the indexing)
+    CategoryIndex(std::vector<Expense> expenses,
+                  const std::map<std::string, std::string>& keyword_map,
+                  RuleStats* rule_stats = nullptr);
+
+    // Switch to a new keyword map, recategorising only the affected rows
+    ReloadStats reload(const std::map<std::string, std::string>& keyword_map);
+
+    const std::vector<Expense>& expenses() const { return expenses_; }
+    
+    // Monthly (Granularity::month()) and weekly (Granularity::week()) totals
+    const TimeBuckets& totals() const { return totals_; }
+
+private:
+    struct RowState {
+        Symbol keyword;          // Empty when uncategorised
+        bool by_name = false;
+        bool inverted = false;
+        uint32_t slot = 0;       // Position in its bucket
+    };
+
+    // Bucket of rows decided by a keyword on the description or on the name;
+    // uncategorised rows share key 0
+    static uint64_t bucketKey(const RowState& state) {
+        return (uint64_t{state.keyword.id()} << 1) | (state.by_name ? 1 : 0);
+    }
+
+    static bool hasEmptyCategory(const std::map<std::string, std::string>& keyword_map);
+
+    // Add a row to, or take it out of, the bucket its state names
+    void link(uint32_t row);
+    void unlink(uint32_t row);
+
+    // Keyword that decided a categorisation, interned through rule_keywords_
+    Symbol decidingKeyword(const TransactionCategorisation& categoriser,
+                           const CategoryDecision& decision);
+    
+    // Re-run categorisation on one row and move it between buckets and totals
+    void recategorise(uint32_t row, const TransactionCategorisation& categoriser,
+                      ReloadStats& stats);
+
+    std::map<std::string, std::string> keyword_map_;
+    std::vector<Expense> expenses_;
+    std::vector<RowState> states_;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets_;
+    std::vector<Symbol> rule_keywords_;      // By rank, interned on first use
+    TimeBuckets totals_;
+};
+
+} // namespace finance
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "string_pool.hpp"
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Remembers the categorisation of each (description, name) pair so repeated
+// merchants skip keyword matching. Entries are tied to a fingerprint of the
+// keyword rules; a memo saved under other rules is ignored on load.
+//
+// The saved form is an open-addressing hash table that is memory-mapped and
+// probed in place on the next load; entries added since then live in memory
+// until the next save. Slots hold a hash of their key and the key bytes are
+// stored beside the table, so a hash collision reads as a miss rather than
+// another merchant's entry. Lookups and inserts may run on several threads.
+class CategoryMemo {
+public:
+    struct Entry {
+        Symbol category;
+        bool invert_amount = false;   // Credit card repayment sign flip
+    };
+    
+    explicit CategoryMemo(uint64_t rules_fingerprint);
+    
+    CategoryMemo(const CategoryMemo&) = delete;
+    CategoryMemo& operator=(const CategoryMemo&) = delete;
+    
+    // Map a saved memo; returns false (leaving the memo empty) if it is
+    // missing, corrupt or was built from other rules
+    bool load(const std::string& filepath);
+    
+    // Write every known entry as a fresh table, replacing the file atomically
+    void save(const std::string& filepath) const;
+    
+    bool find(std::string_view description, std::string_view name, Entry& entry) const;
+    void insert(std::string_view description, std::string_view name,
+                Symbol category, bool invert_amount);
+    
+    size_t size() const;
+    
+    // Whether entries were added since the memo was loaded
+    bool modified() const;
+
+private:
+    // One table slot as stored on disk; value is (category id << 1) | invert.
+    // The key is description, '\x1f', name, at key_offset in the key bytes.
+    struct Slot {
+        uint64_t key_hash;
+        uint64_t key_offset;
+        uint32_t key_length;
+        uint32_t value;
+    };
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+    
+    static uint64_t keyHash(std::string_view description, std::string_view name);
+    
+    // Whether key holds description and name
+    static bool keyMatches(std::string_view key, std::string_view description,
+                           std::string_view name);
+    
+    // Probe the loaded table (slot count a power of two)
+    const Slot* probe(uint64_t hash, std::string_view description, std::string_view name) const;
+    
+    // Entry added this run
+    struct Added {
+        std::string key;
+        uint32_t value;
+    };
+    const Added* findAdded(uint64_t hash, std::string_view description, std::string_view name) const;
+    
+    uint32_t categoryId(Symbol category);
+    
+    uint64_t rules_fingerprint_;
+    
+    // Table loaded from disk, probed in place
+    MappedFile mapping_;
+    std::string loaded_bytes_;          // Used when the file cannot be mapped
+    const Slot* loaded_slots_ = nullptr;
+    size_t loaded_slot_count_ = 0;
+    std::string_view loaded_keys_;
+    size_t loaded_entries_ = 0;
+    
+    // Category names by id (loaded ones first) and entries added this run
+    mutable std::shared_mutex mutex_;
+    std::vector<Symbol> categories_;
+    std::unordered_map<uint32_t, uint32_t> category_ids_;   // By symbol id
+    std::unordered_multimap<uint64_t, Added> added_;   // Keyed by key hash
+};
+
+} // namespace finance
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace finance {
+
+// Calendar date held as a day number (days since 1970-01-01, proleptic
+// Gregorian). Conversions use integer arithmetic only, so they are
+// independent of the local timezone and safe on any thread.
+class CivilDate {
+public:
+    constexpr CivilDate() = default;
+
+    static constexpr CivilDate fromDayNumber(int32_t days) {
+        CivilDate date;
+        date.days_ = days;
+        return date;
+    }
+
+    // Day values past the end of the month roll over into the next one
+    static constexpr CivilDate fromYmd(int year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+        const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return fromDayNumber(era * 146097 + static_cast<int32_t>(day_of_era) - 719468);
+    }
+
+    constexpr int32_t dayNumber() const { return days_; }
+
+    constexpr void toYmd(int& year, unsigned& month, unsigned& day) const {
+        const int32_t days = days_ + 719468;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+        const unsigned year_of_era =
+            (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        const unsigned mp = (5 * day_of_year + 2) / 153;
+        day = day_of_year - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<int>(year_of_era) + era * 400 + (month <= 2);
+    }
+
+    // Day of the week, Monday = 0 ... Sunday = 6 (1970-01-01 was a Thursday)
+    constexpr unsigned weekday() const {
+        return static_cast<unsigned>(days_ >= -3 ? (days_ + 3) % 7 : (days_ + 4) % 7 + 6);
+    }
+
+    // Monday on or before this date
+    constexpr CivilDate weekStart() const {
+        return fromDayNumber(days_ - static_cast<int32_t>(weekday()));
+    }
+
+    // Months since year 0 (year * 12 + month - 1); orders like the dates
+    constexpr int32_t monthKey() const {
+        int year = 0;
+        unsigned month = 0, day = 0;
+        toYmd(year, month, day);
+        return year * 12 + static_cast<int32_t>(month) - 1;
+    }
+
+    // Write "DD/MM/YYYY" (10 chars) at out; returns the end
+    char* writeDayMonthYear(char* out) const {
+        int year = 0;
+        unsigned month = 0, day = 0;
+        toYmd(year, month, day);
+        writeDigits(out, day, 2);
+        out[2] = '/';
+        writeDigits(out + 3, month, 2);
+        out[5] = '/';
+        writeDigits(out + 6, static_cast<unsigned>(year), 4);
+        return out + 10;
+    }
+
+    // "DD/MM/YYYY"
+    std::string formatDayMonthYear() const {
+        char buffer[10];
+        return std::string(buffer, writeDayMonthYear(buffer));
+    }
+
+    // "YYYY-MM-DD"
+    std::string formatIso() const {
+        int year = 0;
+        unsigned month = 0, day = 0;
+        toYmd(year, month, day);
+        char buffer[10];
+        writeDigits(buffer, static_cast<unsigned>(year), 4);
+        buffer[4] = '-';
+        writeDigits(buffer + 5, month, 2);
+        buffer[7] = '-';
+        writeDigits(buffer + 8, day, 2);
+        return std::string(buffer, sizeof(buffer));
+    }
+
+    // Write "YYYY-MM" (7 chars) for a key from monthKey() at out; returns the end
+    static char* writeMonthKey(char* out, int32_t month_key) {
+        writeDigits(out, static_cast<unsigned>(month_key / 12), 4);
+        out[4] = '-';
+        writeDigits(out + 5, static_cast<unsigned>(month_key % 12 + 1), 2);
+        return out + 7;
+    }
+
+    // "YYYY-MM" for a key from monthKey()
+    static std::string formatMonthKey(int32_t month_key) {
+        char buffer[7];
+        return std::string(buffer, writeMonthKey(buffer, month_key));
+    }
+
+    // "YYYY-MM"
+    std::string formatMonth() const { return formatMonthKey(monthKey()); }
+
+    constexpr bool operator==(CivilDate other) const { return days_ == other.days_; }
+    constexpr bool operator!=(CivilDate other) const { return days_ != other.days_; }
+    constexpr bool operator<(CivilDate other) const { return days_ < other.days_; }
+
+private:
+    // Zero-padded decimal of fixed width (years are 0-9999 in practice)
+    static void writeDigits(char* out, unsigned value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    int32_t days_ = 0;
+};
+
+} // namespace finance
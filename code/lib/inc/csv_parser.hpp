@@ -1,26 +1,60 @@
 #pragma once
 
 #include "finance_types.hpp"
+#include "csv_scanner.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace finance {
 
+// Splits CSV lines into trimmed field views without allocating per field.
+// Views point either into the tokenized line or into an internal buffer and
+// remain valid until the next call to tokenize().
+class CSVTokenizer {
+public:
+    explicit CSVTokenizer(ScanKernel kernel = CSVScanner::bestKernel())
+        : scanner_(kernel) {}
+    
+    // Tokenize a line, handling quoted values; returns the number of fields.
+    // Scanning stops once max_fields fields have been found.
+    size_t tokenize(std::string_view line, size_t max_fields = SIZE_MAX);
+    
+    size_t size() const { return offsets_.size(); }
+    std::string_view operator[](size_t index) const {
+        const FieldSpan& span = offsets_[index];
+        return std::string_view(data_ + span.begin, span.end - span.begin);
+    }
+
+private:
+    struct FieldSpan {
+        uint32_t begin;
+        uint32_t end;
+    };
+    
+    // Append a field span, trimming leading/trailing whitespace
+    void addField(uint32_t begin, uint32_t end);
+    
+    CSVScanner scanner_;             // Locates separators and quotes per block
+    const char* data_ = nullptr;     // Base of the current line's characters
+    std::string buffer_;             // Reusable line buffer for unquoted copies
+    std::vector<FieldSpan> offsets_; // Reusable field-offset array
+};
+
 // Handles CSV file parsing and field extraction
 class CSVParser {
 public:
     // Parse CSV header to identify column positions
-    static CSVColumns parseHeader(const std::string& header_line);
-    
-    // Parse a CSV line into fields, handling quoted values
-    static std::vector<std::string> parseLine(const std::string& line);
+    static CSVColumns parseHeader(std::string_view header_line);
     
     // Clean and standardize field values
-    static std::string cleanField(const std::string& field);
+    static std::string cleanField(std::string_view field);
 
 private:
     // Remove quotes and whitespace from a field
     static std::string removeQuotesAndWhitespace(const std::string& field);
 };
 
-} // namespace finance 
\ No newline at end of file
+} // namespace finance
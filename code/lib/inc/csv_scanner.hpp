@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace finance {
+
+// Instruction set used to classify CSV structural characters
+enum class ScanKernel {
+    Scalar, // Portable byte-at-a-time fallback
+    SSE2,   // 16 bytes per compare (x86-64 baseline)
+    AVX2    // 32 bytes per compare (selected at runtime when supported)
+};
+
+// Structural character positions within one block (bit i = byte i)
+struct StructuralMasks {
+    uint64_t comma = 0;
+    uint64_t quote = 0;
+    uint64_t newline = 0;
+};
+
+// Finds commas, quotes and line feeds a block at a time using SIMD compares.
+// Every kernel produces identical masks; only throughput differs.
+class CSVScanner {
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+    
+    explicit CSVScanner(ScanKernel kernel = bestKernel());
+    
+    // Classify up to BLOCK_SIZE bytes; bits past length are always clear
+    StructuralMasks scanBlock(const char* data, size_t length) const;
+    
+    ScanKernel kernel() const { return kernel_; }
+    
+    // Fastest kernel supported by the running CPU (detected once)
+    static ScanKernel bestKernel();
+    
+    // Whether the running CPU can execute the given kernel
+    static bool isSupported(ScanKernel kernel);
+    
+    static const char* kernelName(ScanKernel kernel);
+    
+    // Offset of the first line feed outside quotes, or length if there is none.
+    // in_quotes carries the quote state across calls and is cleared on a match.
+    size_t findRecordEnd(const char* data, size_t length, bool& in_quotes) const;
+    
+    // Number of quote characters in the range
+    size_t countQuotes(const char* data, size_t length) const;
+    
+    static int countTrailingZeros(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(mask);
+#else
+        int count = 0;
+        for (; !(mask & 1); mask >>= 1) ++count;
+        return count;
+#endif
+    }
+    
+    static int popCount(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(mask);
+#else
+        int count = 0;
+        for (; mask; mask &= mask - 1) ++count;
+        return count;
+#endif
+    }
+    
+    // Bit i of the result is the XOR of bits 0..i of mask; applied to a quote
+    // mask this marks every byte between an opening and closing quote
+    static uint64_t prefixXor(uint64_t mask) {
+        mask ^= mask << 1;
+        mask ^= mask << 2;
+        mask ^= mask << 4;
+        mask ^= mask << 8;
+        mask ^= mask << 16;
+        mask ^= mask << 32;
+        return mask;
+    }
+
+private:
+    using BlockFunction = StructuralMasks (*)(const char* block);
+    
+    ScanKernel kernel_;
+    BlockFunction scan_block_;  // Scans exactly BLOCK_SIZE readable bytes
+};
+
+} // namespace finance
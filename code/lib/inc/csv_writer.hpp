@@ -0,0 +1,102 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace finance {
+
+// Buffered CSV output. Fields are formatted straight into a large buffer
+// (numbers with std::to_chars, dates from their day numbers) and a full
+// buffer goes to the file in a single write. Text fields are quoted, as in
+// RFC 4180, only when they hold a comma, quote or line break; for symbols
+// that is worked out once per distinct string.
+//
+// With background flushing, a full buffer is handed to a writer thread while
+// the next one fills, so formatting overlaps the I/O.
+class CsvWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = size_t{1} << 20;
+
+    enum class Mode {
+        Truncate,
+        Append
+    };
+
+    // Open filepath; throws std::runtime_error if it cannot be opened
+    explicit CsvWriter(const std::string& filepath,
+                       Mode mode = Mode::Truncate,
+                       bool background_flush = false,
+                       size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    // Closes the file if close() was not called; errors are then only reported
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    // Add a field to the current row
+    CsvWriter& field(std::string_view text);
+    CsvWriter& field(Symbol text);
+    CsvWriter& field(Money amount);
+    CsvWriter& field(int64_t value);
+
+    // Add a date field as "DD/MM/YYYY" or as its month, "YYYY-MM"
+    CsvWriter& dayMonthYearField(CivilDate date);
+    CsvWriter& monthField(CivilDate date);
+
+    // Finish the current row
+    void endRow();
+
+    // Hand everything formatted so far to the file
+    void flush();
+
+    // Flush, wait for the writer thread and close the file; throws
+    // std::runtime_error if any write failed
+    void close();
+
+private:
+    // Room for bytes more at the end of the buffer, flushing it if needed;
+    // starts the field with a separator unless it is first in its row
+    char* beginField(size_t bytes);
+
+    static bool needsQuotes(std::string_view text);
+    CsvWriter& plainField(std::string_view text);
+    CsvWriter& quotedField(std::string_view text);
+
+    // Write size bytes to the file (on whichever thread flushes)
+    bool writeOut(const char* data, size_t size);
+
+    void flushLoop();
+
+    std::string filepath_;
+    std::FILE* file_ = nullptr;
+    std::vector<char> buffer_;   // Being filled
+    size_t used_ = 0;
+    bool row_started_ = false;
+    bool failed_ = false;
+
+    // Per symbol id: 0 not seen yet, else PLAIN or QUOTED
+    static constexpr uint8_t PLAIN = 1;
+    static constexpr uint8_t QUOTED = 2;
+    std::vector<uint8_t> symbol_quoting_;
+
+    // Background flushing: the filled buffer is swapped into pending_
+    bool background_ = false;
+    std::thread flusher_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<char> pending_;
+    size_t pending_size_ = 0;
+    bool has_pending_ = false;
+    bool stopping_ = false;
+};
+
+} // namespace finance
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "csv_writer.hpp"
+#include "expense_cube.hpp"
 #include "finance_types.hpp"
 #include "report_generator.hpp"
+#include "time_buckets.hpp"
+#include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,16 +23,65 @@ public:
     // Export data to files
     void exportData(const std::vector<Expense>& expenses);
     
+    // Export with the summaries already accumulated elsewhere (such as the
+    // totals a CategoryIndex keeps up to date); summaries at granularities
+    // totals lacks are rolled up from the cube
+    void exportData(const std::vector<Expense>& expenses, const TimeBuckets& totals);
+    
+    // Totals of expenses with one granularity per summary, in order, to keep
+    // for appendData()
+    TimeBuckets summaryTotals(const std::vector<Expense>& expenses) const;
+    
+    // Export expenses arriving after an earlier export whose summaryTotals()
+    // and cube were kept: add them to totals and cube, rewrite only the
+    // summaries they change and append their rows to the transactions file.
+    // The cube is then kept as this exporter's. Returns false, changing
+    // nothing, if totals lacks one of the summaries.
+    bool appendData(const std::vector<Expense>& expenses, TimeBuckets& totals,
+                    std::shared_ptr<ExpenseCube> cube);
+    
+    // Also write a summary at another granularity, such as
+    // Granularity::quarter() to "quarterly_summary.csv". The monthly and
+    // weekly flags add "monthly_summary.csv" (Granularity::month()) and
+    // "weekly_summary.csv" (Granularity::week()). Every summary is rolled
+    // up from the cube, so none adds a pass over the expenses.
+    void addSummary(const Granularity& granularity, const std::string& filename);
+    
+    // Incremental export for streaming: begin(), add() per batch, finish().
+    // Expenses are aggregated into the cube as they arrive and transaction
+    // rows are written straight through to disk, on a background thread.
+    void begin();
+    void add(const std::vector<Expense>& expenses);
+    void finish();
+    
+    // Cube of every expense exported since begin() (null before)
+    std::shared_ptr<const ExpenseCube> cube() const { return cube_; }
+    
 private:
     std::string output_dir_;
-    bool export_monthly_;
-    bool export_weekly_;
+    Symbol uncategorised_;   // Stands in for an empty category
     bool export_entire_;
     
+    struct Summary {
+        Granularity granularity;
+        std::string filename;
+    };
+    std::vector<Summary> summaries_;
+    
+    std::shared_ptr<ExpenseCube> cube_;
+    std::unique_ptr<CsvWriter> entire_file_;
+    
+    // Category x period table of one summary file
+    struct SummaryTable {
+        std::vector<std::string> periods;   // Labels, in order
+        std::vector<Symbol> categories;     // In alphabetical order
+        std::vector<Money> totals;          // [category * periods.size() + period]
+    };
+    static SummaryTable summaryTable(const TimeBuckets& totals, size_t index);
+    static SummaryTable summaryTable(const ExpenseCube& cube, const Granularity& granularity);
+    
     // Helper functions
-    void exportMonthlyData(const std::vector<Expense>& expenses);
-    void exportWeeklyData(const std::vector<Expense>& expenses);
-    void exportEntireData(const std::vector<Expense>& expenses);
+    void writeSummary(const SummaryTable& table, const std::string& filename);
 };
 
-} // namespace finance 
\ No newline at end of file
+} // namespace finance
@@ -1,30 +1,127 @@
 #pragma once
 
+#include "finance_types.hpp"
+#include "csv_parser.hpp"
+#include "schema_registry.hpp"
 #include <string>    
+#include <string_view>
 #include <vector>   
 #include <memory>  
 #include <chrono>   
+#include <functional>
 
 namespace finance {
 
 class DataLoader {
 public:
-    explicit DataLoader(const std::string& directory);
+    // When use_memory_map is set, regular files are parsed straight out of a
+    // read-only mapping; other inputs fall back to stream reading.
+    // max_threads bounds all parsing threads, across files and the chunks of
+    // large files (0 = one per hardware thread).
+    explicit DataLoader(const std::string& directory,
+                        bool use_memory_map = true,
+                        size_t max_threads = 0);
 
     std::vector<Expense> loadAndPreprocessData();
+    
+    // Keep a columnar cache of each parsed file in cache_directory and load
+    // from it while it still matches the source (empty = no caching)
+    void setCacheDirectory(const std::string& cache_directory);
+    
+    // Location of the cache kept for an input file
+    std::string cachePathFor(const std::string& filepath) const;
+    
+    // Resolve files whose header matches a registered profile through it;
+    // other files fall back to guessing columns from the header names
+    void setSchemaRegistry(std::shared_ptr<const SchemaRegistry> schemas);
+    
+    // CSV files in the input directory, sorted by name
+    std::vector<std::string> listInputFiles() const;
+    
+    // Parse the given files concurrently; result i holds the rows of file i
+    std::vector<std::vector<Expense>> loadFiles(const std::vector<std::string>& filepaths);
+    
+    // Source details shared by every batch read from one input file
+    struct InputFile {
+        std::string filepath;
+        std::string file_origin;
+        SchemaProfile profile;
+    };
+    
+    // Raw records of one input file, read ahead of parsing in streaming mode
+    struct RecordBatch {
+        std::shared_ptr<const InputFile> file;
+        std::string text;                  // Record bytes stored back to back
+        std::vector<size_t> record_ends;   // End offset of each record in text
+    };
+    
+    // Read every input file in name order and hand its records to sink in
+    // batches of up to batch_size; stops early when sink returns false
+    void readRecordBatches(size_t batch_size,
+                           const std::function<bool(RecordBatch&&)>& sink);
+    
+    // Parse a batch produced by readRecordBatches
+    std::vector<Expense> parseRecordBatch(const RecordBatch& batch);
 
 private:
     std::string getFileOrigin(const std::string& basename);
     
-    // Process a single CSV file
-    std::vector<Expense> processFile(const std::string& filepath);
+    // Process a single CSV file, going through the cache when enabled;
+    // thread_count is the file's share of the loader's threads
+    std::vector<Expense> processFile(const std::string& filepath, size_t thread_count);
+    
+    // Parse a single CSV file on up to thread_count threads
+    std::vector<Expense> parseFile(const std::string& filepath, size_t thread_count);
+    
+    // Parse a mapped file, splitting large files into record-aligned chunks
+    // that are parsed on up to thread_count threads and stitched back
+    // together in file order
+    std::vector<Expense> processMappedFile(std::string_view contents,
+                                           const std::string& filepath,
+                                           size_t thread_count);
+    
+    // Batch the records of one file for readRecordBatches
+    template <typename RecordReader>
+    bool readFileBatches(RecordReader& reader,
+                         const std::string& filepath,
+                         size_t batch_size,
+                         const std::function<bool(RecordBatch&&)>& sink);
+    
+    // Read the header record and resolve the file's profile
+    template <typename RecordReader>
+    bool readHeader(RecordReader& reader, const std::string& filepath,
+                    SchemaProfile& profile);
+    
+    // Registered profile for a header, or one guessed from the column names
+    SchemaProfile resolveProfile(std::string_view header_line) const;
+    
+    // Parse the remaining records supplied by a reader (mapped or streamed)
+    template <typename RecordReader>
+    void parseRows(RecordReader& reader,
+                   const SchemaProfile& profile,
+                   const std::string& file_origin,
+                   const std::string& filepath,
+                   std::vector<Expense>& expenses);
+    
+    // Tokenize each record, splitting at most field_limit fields, and decode
+    // it into an expense; bad rows are reported and skipped
+    template <typename RecordReader, typename Decode>
+    void decodeRows(RecordReader& reader,
+                    size_t field_limit,
+                    const std::string& filepath,
+                    std::vector<Expense>& expenses,
+                    Decode decode);
     
-    // Create expense object from CSV fields
-    Expense createExpense(const std::vector<std::string>& fields, 
-                         const CSVColumns& cols,
-                         const std::string& file_origin);
+    // Create expense object from CSV fields (generic profile-driven path)
+    Expense createExpense(const CSVTokenizer& fields, 
+                         const SchemaProfile& profile,
+                         Symbol file_origin);
 
     std::string directory_;
+    bool use_memory_map_;
+    size_t max_threads_;
+    std::string cache_directory_;
+    std::shared_ptr<const SchemaRegistry> schemas_;
 };
 
 } // namespace finance 
\ No newline at end of file
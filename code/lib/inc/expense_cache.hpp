@@ -0,0 +1,34 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include "input_manifest.hpp"
+#include <string>
+#include <vector>
+
+namespace finance {
+
+// Columnar binary snapshot (.fcache) of the parsed, not yet categorised
+// expenses of one input file. Dates are stored as civil day numbers, amounts
+// as integer minor units and string columns dictionary-encoded. A versioned
+// header records the source file's fingerprint and a payload checksum; the
+// file is memory-mapped on load. Caches are host-local (native byte order).
+class ExpenseCache {
+public:
+    static constexpr const char* FILE_EXTENSION = ".fcache";
+    
+    // Write expenses parsed from a source with the given fingerprint, atomically.
+    // parser_hash identifies the parsing configuration (e.g. schema profiles).
+    static void save(const std::string& cache_path,
+                     const FileFingerprint& source,
+                     uint64_t parser_hash,
+                     const std::vector<Expense>& expenses);
+    
+    // Load the cache if it is intact and still matches source_path and
+    // parser_hash; returns false if missing, stale, corrupt or from another version
+    static bool load(const std::string& cache_path,
+                     const std::string& source_path,
+                     uint64_t parser_hash,
+                     std::vector<Expense>& expenses);
+};
+
+} // namespace finance
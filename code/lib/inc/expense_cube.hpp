@@ -0,0 +1,144 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include "time_buckets.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Pre-aggregated expenses over four dimensions: category, period, file origin
+// (account) and currency. Each cell holds the sum, count, min and max of its
+// rows' GBP amounts (converted per row, as in the summaries). Queries slice
+// and roll up cells, never rows.
+//
+// Cells are kept at two levels, per day and per month, each in a flat
+// open-addressing table. A query reads the month cells whenever its
+// granularity and date range are made of whole months, and the day cells
+// otherwise, and rolls them up into a dense array indexed by the grouped
+// dimensions.
+//
+// The day cells can be saved and loaded again, so later runs can add rows to
+// the cube of earlier ones.
+class ExpenseCube {
+public:
+    // Dimensions a query groups by (combine with |)
+    enum Dimension : unsigned {
+        CATEGORY = 1,
+        PERIOD = 2,
+        ORIGIN = 4,
+        CURRENCY = 8
+    };
+
+    struct Measures {
+        Money sum;
+        size_t count = 0;
+        Money min;
+        Money max;
+
+        void add(Money amount);
+        void merge(const Measures& other);
+    };
+
+    // Cells of a query: dimensions not grouped by are left at their
+    // defaults, and period is a key of the query's granularity
+    struct Cell {
+        Symbol category;
+        int32_t period = 0;
+        Symbol origin;
+        Currency currency = Currency::UNKNOWN;
+        Measures measures;
+    };
+
+    // Rows to include; empty lists include every value, and the default
+    // dates include every day
+    struct Slice {
+        std::vector<Symbol> categories;
+        std::vector<Symbol> origins;
+        std::vector<Currency> currencies;
+        CivilDate first = CivilDate::fromDayNumber(INT32_MIN);
+        CivilDate last = CivilDate::fromDayNumber(INT32_MAX);
+    };
+
+    // Add every expense (empty categories count as uncategorised)
+    void add(const std::vector<Expense>& expenses, Symbol uncategorised);
+
+    void add(const Expense& expense, Symbol category);
+
+    // Roll the cells in slice up to the dimensions in group_by, with periods
+    // at granularity. Cells come sorted by category name, period, origin
+    // name and currency.
+    std::vector<Cell> query(unsigned group_by, const Granularity& granularity,
+                            const Slice& slice) const;
+    std::vector<Cell> query(unsigned group_by,
+                            const Granularity& granularity = Granularity::day()) const {
+        return query(group_by, granularity, Slice());
+    }
+
+    // Measures over every row in slice
+    Measures total(const Slice& slice) const;
+    Measures total() const { return total(Slice()); }
+
+    size_t cellCount() const { return days_.cells.size(); }   // Day cells
+    size_t rowCount() const { return row_count_; }
+
+    // Write every cell, tagged with fingerprint, replacing the file atomically
+    void save(const std::string& filepath, uint64_t fingerprint) const;
+
+    // Replace the cells with saved ones; returns false (leaving these
+    // unchanged) if the file is missing, corrupt, from another version or was
+    // saved with another fingerprint
+    bool load(const std::string& filepath, uint64_t fingerprint);
+
+private:
+    // Category and origin are slots into categories_ and origins_
+    struct Key {
+        uint32_t category;
+        uint32_t origin;
+        int32_t period;
+        Currency currency;
+
+        bool operator==(const Key& other) const {
+            return category == other.category && origin == other.origin &&
+                   period == other.period && currency == other.currency;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        Measures measures;
+    };
+
+    // Cells at one period granularity
+    struct Level {
+        std::vector<Entry> cells;
+        std::vector<uint32_t> table;    // Cell index + 1, or 0 when empty
+        int32_t first_period = INT32_MAX;
+        int32_t last_period = INT32_MIN;
+
+        // Measures of the cell for key, added empty if it is new
+        Measures& at(const Key& key);
+        void rehash(size_t capacity);
+    };
+
+    static size_t hashKey(const Key& key);
+    static uint32_t slotOf(Symbol symbol, std::vector<Symbol>& symbols,
+                           std::unordered_map<uint32_t, uint32_t>& slots);
+
+    // Whether a query can be answered from whole months
+    static bool monthAligned(unsigned group_by, const Granularity& granularity,
+                             const Slice& slice);
+
+    std::vector<Symbol> categories_;   // By slot
+    std::vector<Symbol> origins_;
+    std::unordered_map<uint32_t, uint32_t> category_slots_;   // Symbol id -> slot
+    std::unordered_map<uint32_t, uint32_t> origin_slots_;
+    Level days_;     // Periods are day numbers
+    Level months_;   // Periods are month keys
+    size_t row_count_ = 0;
+};
+
+} // namespace finance
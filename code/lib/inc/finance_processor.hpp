@@ -1,9 +1,26 @@
 #pragma once
 
+#include "expense_cube.hpp"
+#include "finance_types.hpp"
+#include "input_manifest.hpp"
+#include "rule_pack.hpp"
+#include "rule_stats.hpp"
+#include "schema_registry.hpp"
+#include "category_index.hpp"
+#include "category_memo.hpp"
+#include "transaction_categorisation.hpp"
+#include "time_buckets.hpp"
+#include <cstddef>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 class FinanceProcessor {
 public:
+    // Rows per batch handed between streaming pipeline stages
+    static constexpr size_t DEFAULT_STREAMING_BATCH_SIZE = 4096;
+    
     // Constructor takes input and output directories, and export options
     FinanceProcessor(const std::string& directory,
                     const std::string& output_dir,
@@ -12,14 +29,120 @@ public:
                     bool export_weekly_summary = false,
                     bool export_full_dataset = true);
     
+    // Process through a bounded streaming pipeline instead of loading every
+    // expense up front; peak memory then depends on batch size, not history
+    void setStreamingMode(bool enabled, size_t batch_size = DEFAULT_STREAMING_BATCH_SIZE);
+    
+    // Reuse parsed rows of input files unchanged since the last run, tracked
+    // by a manifest in the output directory, and remember the category of
+    // each merchant across runs (enabled by default; rows are reused in
+    // batch mode only). The summary totals and cube are kept too, so a run
+    // whose only change is new input files, named after every earlier one,
+    // loads just those, adds them to the totals and cube, rewrites the
+    // summaries and appends to categorised_transactions.csv.
+    void setIncrementalMode(bool enabled);
+    
+    // Worker threads for parsing files and categorising expenses
+    // (0 = one per hardware thread, the default)
+    void setThreadCount(size_t thread_count);
+    
+    // Bank format profiles to recognise inputs by (default: bank_schemas.csv
+    // beside the keyword file, used if present; empty path disables)
+    void setSchemaFile(const std::string& schema_file);
+    
+    // Keep the categorised rows of a batch run indexed by the keyword that
+    // decided each one, so reloadKeywords() can apply keyword edits without
+    // reprocessing (off by default; holds every expense in memory)
+    void setKeywordHotReload(bool enabled);
+    
+    // Count the keyword deciding each expense and time the matching, written
+    // as categorisation_stats.csv (one row per keyword, with hit counts, first
+    // and last match dates and examples) and categorisation_stats.json
+    // (totals) in the output directory. Off by default; while on, the
+    // category memo is not consulted so every expense is matched.
+    void setCategorisationStats(bool enabled);
+    
     // Main processing function
     void run();
     
+    // Re-read the keyword file and recategorise only the rows its changes can
+    // affect, rewriting the outputs if any changed. Returns false (doing
+    // nothing) unless a batch run() with hot reload enabled came first.
+    bool reloadKeywords();
+    
+    // Cube of the expenses exported by the last run() or reloadKeywords(),
+    // for slicing and rolling up without the rows; null when nothing was
+    // processed (such as when the outputs were already up to date)
+    std::shared_ptr<const finance::ExpenseCube> cube() const { return cube_; }
+    
 private:
     std::string directory_;
     std::string output_dir_;
     std::string keyword_file_;
+    std::string schema_file_;
+    std::shared_ptr<const finance::SchemaRegistry> schemas_;
     bool export_monthly_summary_;
     bool export_weekly_summary_;
     bool export_full_dataset_;
-}; 
\ No newline at end of file
+    bool streaming_ = false;
+    size_t streaming_batch_size_ = DEFAULT_STREAMING_BATCH_SIZE;
+    bool incremental_ = true;
+    size_t thread_count_ = 0;
+    bool hot_reload_ = false;
+    bool categorisation_stats_ = false;
+    std::unique_ptr<finance::CategoryIndex> category_index_;
+    std::shared_ptr<const finance::ExpenseCube> cube_;
+    
+    // Read -> parse -> categorise -> aggregate/write, connected by bounded queues
+    void runStreaming(std::shared_ptr<const finance::RulePack> rules);
+    
+    // Load all expenses, parsing only files that are new or changed since the
+    // manifest was written. Fills manifest for the current inputs and sets
+    // outputs_current when inputs, keywords and options all still match; no
+    // rows are then loaded unless hot reload needs them.
+    // When the only change is new files sorting after the known ones, and the
+    // summary totals and cube kept with the manifest load into kept_totals
+    // and kept_cube, sets append_only and loads just the new files.
+    std::vector<finance::Expense> loadIncrementally(finance::InputManifest& manifest,
+                                                    bool& outputs_current,
+                                                    finance::TimeBuckets& kept_totals,
+                                                    finance::ExpenseCube& kept_cube,
+                                                    bool& append_only);
+    
+    // Category memo kept in the output directory, attached to categoriser;
+    // nullptr when incremental mode is off
+    std::unique_ptr<finance::CategoryMemo> openCategoryMemo(
+        finance::TransactionCategorisation& categoriser) const;
+    
+    // Persist a memo opened by openCategoryMemo (failures are only reported)
+    void saveCategoryMemo(const finance::CategoryMemo* memo) const;
+    
+    // Write the report and exports, keeping the exporter's cube; summaries
+    // come from index when given
+    void writeOutputs(const std::vector<finance::Expense>& expenses,
+                      const finance::CategoryIndex* index);
+    
+    // Add expenses from new inputs to the outputs, kept_totals and kept_cube,
+    // then keep the totals and cube for manifest
+    void appendOutputs(const std::vector<finance::Expense>& expenses,
+                       finance::TimeBuckets& kept_totals,
+                       std::shared_ptr<finance::ExpenseCube> kept_cube,
+                       const finance::InputManifest& manifest);
+    
+    // Keep the summary totals and the cube of the outputs for later runs that
+    // only append inputs, tied to manifest (failures are only reported)
+    void saveSummaryTotals(const std::vector<finance::Expense>& expenses,
+                           const finance::InputManifest& manifest) const;
+    void saveSummaryTotals(const finance::TimeBuckets& totals,
+                           const finance::InputManifest& manifest) const;
+    
+    std::string summaryTotalsPath() const;
+    std::string expenseCubePath() const;
+    
+    // Write the stats gathered for categoriser's rules
+    void writeRuleStats(const finance::RuleStats& rule_stats,
+                        const finance::TransactionCategorisation& categoriser) const;
+    
+    // Hash of the options (and schema profiles) that shape the outputs
+    uint64_t optionsHash() const;
+};
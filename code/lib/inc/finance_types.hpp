@@ -1,7 +1,10 @@
 #pragma once
 
+#include "civil_date.hpp"
+#include "money.hpp"
+#include "string_pool.hpp"
 #include <string>
-#include <chrono>
+#include <string_view>
 
 namespace finance {
 
@@ -14,7 +17,7 @@ enum class Currency {
 };
 
 // Helper function to convert currency string to enum
-inline Currency stringToCurrency(const std::string& symbol) {
+inline Currency stringToCurrency(std::string_view symbol) {
     if (symbol == "£" || symbol == "GBP" || symbol == "GBR") return Currency::GBP;
     if (symbol == "€" || symbol == "EUR") return Currency::EUR;
     if (symbol == "$" || symbol == "USD") return Currency::USD;
@@ -22,7 +25,7 @@ inline Currency stringToCurrency(const std::string& symbol) {
 }
 
 // Helper function to get currency symbol
-inline std::string currencyToSymbol(Currency currency) {
+inline std::string_view currencyToSymbol(Currency currency) {
     switch (currency) {
         case Currency::GBP: return "GBP";
         case Currency::EUR: return "EUR";
@@ -31,16 +34,31 @@ inline std::string currencyToSymbol(Currency currency) {
     }
 }
 
-// Represents a single financial expense entry
+// Approximate conversion of an amount to GBP, rounded to the penny
+inline Money toGbp(Money amount, Currency currency) {
+    switch (currency) {
+        case Currency::EUR: return amount.scaled(86, 100);
+        case Currency::USD: return amount.scaled(79, 100);
+        default: return amount;
+    }
+}
+
+// Represents a single financial expense entry. Text fields are interned:
+// origins, merchants and categories repeat across many rows.
 struct Expense {
-    std::chrono::system_clock::time_point date;  // Transaction date
-    std::string month;                           // YYYY-MM format for grouping
-    std::string file_origin;                     // Source of the expense data
-    std::string description;                     // Transaction description
-    double amount;                               // Transaction amount
-    Currency currency;                           // Currency of the transaction
-    std::string category;                        // Expense category
-    std::string name;                            // Additional info
+    CivilDate date;                              // Transaction date
+    Symbol file_origin;                          // Source of the expense data
+    Symbol description;                          // Transaction description
+    Money amount;                                // Transaction amount
+    Currency currency = Currency::UNKNOWN;       // Currency of the transaction
+    Symbol category;                             // Expense category
+    Symbol name;                                 // Additional info
+};
+
+// Supported layouts of date fields
+enum class DateFormat {
+    DayMonthYear,   // DD/MM/YYYY
+    YearMonthDay    // YYYY-MM-DD
 };
 
 // Represents column indices in CSV files
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace finance {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+// 64-bit FNV-1a hash; pass a previous result as seed to hash in pieces
+inline uint64_t fnv1a64(std::string_view data, uint64_t seed = FNV_OFFSET_BASIS) {
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Hash of a file's contents; returns false if the file cannot be read
+bool hashFileContents(const std::string& filepath, uint64_t& hash);
+
+// Fixed-width lowercase hex, used for hashes in text files and file names
+std::string toHex(uint64_t value);
+
+} // namespace finance
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace finance {
+
+// Identity of one input file at the time it was last processed
+struct FileFingerprint {
+    uint64_t size = 0;
+    int64_t mtime = 0;          // Last write time in file clock ticks
+    uint64_t content_hash = 0;
+};
+
+// Record of the inputs behind the current outputs, stored in the output
+// directory so the next run can reuse results for unchanged files
+class InputManifest {
+public:
+    // Load a manifest; returns false (leaving it empty) if missing or invalid
+    bool load(const std::string& filepath);
+    
+    // Write the manifest, replacing any previous one
+    void save(const std::string& filepath) const;
+    
+    // Fingerprint a file; the content hash is reused from previous when the
+    // size and mtime are unchanged, so untouched files are never re-read
+    static FileFingerprint fingerprint(const std::string& filepath,
+                                       const FileFingerprint* previous = nullptr);
+    
+    // Hash of the keyword and option hashes and every file's path, size and
+    // content hash, for tying other saved state to exactly these inputs
+    uint64_t contentHash() const;
+    
+    uint64_t keyword_hash = 0;  // Hash of the keyword file contents
+    uint64_t options_hash = 0;  // Hash of the processing options
+    std::map<std::string, FileFingerprint> files;  // Keyed by input path
+};
+
+} // namespace finance
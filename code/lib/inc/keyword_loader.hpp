@@ -1,7 +1,9 @@
 #pragma once
 
-#include <string>
+#include "rule_pack.hpp"
 #include <map>
+#include <memory>
+#include <string>
 
 namespace finance {
 
@@ -13,6 +15,12 @@ public:
     // Load keywords from file and return as a map
     std::map<std::string, std::string> loadKeywords();
     
+    // Load the keywords as a compiled rule pack. A pack at pack_path built
+    // from the file's current contents is mapped as is; otherwise the file is
+    // parsed and the pack rebuilt there (only in memory if pack_path is
+    // empty or cannot be written). Throws like loadKeywords().
+    std::shared_ptr<const RulePack> loadRulePack(const std::string& pack_path);
+    
 private:
     std::string filepath_;
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "string_pool.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finance {
+
+// Keyword rules compiled into an Aho-Corasick automaton over ASCII
+// case-folded bytes, so a text is matched against every keyword in one
+// linear scan. Among the keywords found, the one first in map order wins.
+class KeywordMatcher {
+public:
+    // Automaton tables, as stored in a rule pack
+    struct Tables {
+        const uint16_t* byte_class;     // [256] folded byte -> alphabet class
+        uint32_t class_count;
+        const uint32_t* transitions;    // [state_count * class_count]
+        const uint32_t* best_rank;      // [state_count]
+        size_t state_count;
+        uint32_t empty_rank;
+    };
+    
+    // keyword_map maps keywords to categories; keywords match case-insensitively
+    explicit KeywordMatcher(const std::map<std::string, std::string>& keyword_map);
+    
+    // Match with tables built earlier (such as a mapped rule pack) without
+    // copying them; they must outlive the matcher. categories is by rank.
+    KeywordMatcher(const Tables& tables, std::vector<Symbol> categories);
+    
+    // Tables point into owned storage, which moves with the matcher
+    KeywordMatcher(const KeywordMatcher&) = delete;
+    KeywordMatcher& operator=(const KeywordMatcher&) = delete;
+    KeywordMatcher(KeywordMatcher&&) = default;
+    KeywordMatcher& operator=(KeywordMatcher&&) = default;
+    
+    static constexpr uint32_t NO_MATCH = UINT32_MAX;
+    
+    // Category of the first keyword (in map order) contained in text, or nullptr
+    const Symbol* findCategory(std::string_view text) const;
+    
+    // Rank (map position) of that keyword, or NO_MATCH
+    uint32_t findRank(std::string_view text) const { return firstMatch(text); }
+    
+    // Category of the keyword with a given rank
+    Symbol category(uint32_t rank) const { return categories_[rank]; }
+    
+    size_t keywordCount() const { return categories_.size(); }
+    size_t stateCount() const { return state_count_; }
+    
+    Tables tables() const;
+
+private:
+    // Lowest rank (map position) of any keyword contained in text
+    uint32_t firstMatch(std::string_view text) const;
+    
+    std::array<uint16_t, 256> byte_class_{};  // Folded byte -> alphabet class
+    uint32_t class_count_ = 1;                // Class 0 is every unused byte
+    const uint32_t* transitions_ = nullptr;   // [state * class_count_ + class]
+    const uint32_t* best_rank_ = nullptr;     // Lowest rank ending at or via suffix
+    size_t state_count_ = 0;
+    std::vector<uint32_t> owned_transitions_; // Storage when built here
+    std::vector<uint32_t> owned_best_rank_;
+    std::vector<Symbol> categories_;          // Category by rank
+    uint32_t empty_rank_ = NO_MATCH;          // Rank of an empty keyword, if any
+};
+
+} // namespace finance
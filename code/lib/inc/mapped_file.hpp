@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace finance {
+
+// Read-only memory mapping of a regular file.
+// Mapping is unavailable for pipes, special files, empty files and on
+// platforms without mmap; callers fall back to stream reading in that case.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    // Map the file for sequential reading; returns false if it cannot be mapped
+    bool open(const std::string& filepath);
+    
+    // Release the mapping
+    void close();
+    
+    bool isOpen() const { return data_ != nullptr; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace finance
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace finance {
+
+// Fixed-point amount held as a whole number of minor units (pence, cents).
+// Sums are exact, so totals do not depend on the order rows are added in.
+class Money {
+public:
+    static constexpr int64_t MINOR_PER_MAJOR = 100;
+    static constexpr int DECIMAL_PLACES = 2;
+
+    constexpr Money() = default;
+
+    static constexpr Money fromMinor(int64_t minor_units) {
+        Money money;
+        money.minor_ = minor_units;
+        return money;
+    }
+
+    constexpr int64_t minorUnits() const { return minor_; }
+    double toDouble() const { return static_cast<double>(minor_) / MINOR_PER_MAJOR; }
+
+    // Multiply by numerator / denominator, rounding half away from zero
+    constexpr Money scaled(int64_t numerator, int64_t denominator) const {
+        const int64_t product = minor_ * numerator;
+        const int64_t half = denominator / 2;
+        return fromMinor(product >= 0 ? (product + half) / denominator
+                                      : (product - half) / denominator);
+    }
+
+    constexpr Money abs() const { return fromMinor(minor_ < 0 ? -minor_ : minor_); }
+
+    constexpr Money operator-() const { return fromMinor(-minor_); }
+    constexpr Money operator+(Money other) const { return fromMinor(minor_ + other.minor_); }
+    constexpr Money operator-(Money other) const { return fromMinor(minor_ - other.minor_); }
+    Money& operator+=(Money other) { minor_ += other.minor_; return *this; }
+    Money& operator-=(Money other) { minor_ -= other.minor_; return *this; }
+
+    constexpr bool operator==(Money other) const { return minor_ == other.minor_; }
+    constexpr bool operator!=(Money other) const { return minor_ != other.minor_; }
+    constexpr bool operator<(Money other) const { return minor_ < other.minor_; }
+
+    // Parse a plain decimal ("-1234.5", "+.99") from the start of text without
+    // allocating. Digits past the second decimal place round half away from
+    // zero and anything after the number is ignored. Returns false if there
+    // are no digits or the value does not fit.
+    static bool parse(std::string_view text, Money& out) {
+        const char* first = text.data();
+        const char* last = first + text.size();
+
+        bool negative = false;
+        if (first != last && (*first == '-' || *first == '+')) {
+            negative = *first == '-';
+            ++first;
+        }
+
+        uint64_t whole = 0;
+        const char* digits_end = first;
+        if (first != last && *first >= '0' && *first <= '9') {
+            auto [end, error] = std::from_chars(first, last, whole);
+            if (error != std::errc()) {
+                return false;
+            }
+            digits_end = end;
+        }
+        bool has_digits = digits_end != first;
+
+        uint64_t fraction = 0;
+        const char* cursor = digits_end;
+        if (cursor != last && *cursor == '.') {
+            ++cursor;
+            int places = 0;
+            bool round_up = false;
+            while (cursor != last && *cursor >= '0' && *cursor <= '9') {
+                if (places < DECIMAL_PLACES) {
+                    fraction = fraction * 10 + static_cast<uint64_t>(*cursor - '0');
+                } else if (places == DECIMAL_PLACES) {
+                    round_up = *cursor >= '5';
+                }
+                ++places;
+                ++cursor;
+                has_digits = true;
+            }
+            for (; places < DECIMAL_PLACES; ++places) {
+                fraction *= 10;
+            }
+            fraction += round_up ? 1 : 0;
+        }
+        if (!has_digits) {
+            return false;
+        }
+
+        constexpr uint64_t MAX_WHOLE = static_cast<uint64_t>(INT64_MAX) / MINOR_PER_MAJOR - 1;
+        if (whole > MAX_WHOLE) {
+            return false;
+        }
+        const int64_t minor = static_cast<int64_t>(whole * MINOR_PER_MAJOR + fraction);
+        out = fromMinor(negative ? -minor : minor);
+        return true;
+    }
+
+    // Longest text toChars() writes: sign, 17 whole digits, point, 2 places
+    static constexpr size_t MAX_CHARS = 21;
+
+    // Write "-12.34" at out, which must have room for MAX_CHARS; returns the end
+    char* toChars(char* out) const {
+        const uint64_t magnitude = minor_ < 0 ? 0 - static_cast<uint64_t>(minor_)
+                                              : static_cast<uint64_t>(minor_);
+        if (minor_ < 0) {
+            *out++ = '-';
+        }
+        out = std::to_chars(out, out + MAX_CHARS - 1, magnitude / MINOR_PER_MAJOR).ptr;
+        *out++ = '.';
+        uint64_t fraction = magnitude % MINOR_PER_MAJOR;
+        for (int place = DECIMAL_PLACES - 1; place >= 0; --place) {
+            out[place] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        return out + DECIMAL_PLACES;
+    }
+
+    // "-12.34"
+    std::string toString() const {
+        char buffer[MAX_CHARS];
+        return std::string(buffer, toChars(buffer));
+    }
+
+private:
+    int64_t minor_ = 0;
+};
+
+} // namespace finance
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace finance {
+
+// Number of worker threads to use when the caller asks for 0 (automatic)
+inline size_t defaultThreadCount() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
+// Run task(index) for every index in [0, count) on at most max_threads
+// threads (0 = one per hardware thread). Indexes are handed out dynamically
+// so uneven task sizes balance out. The first exception thrown by a task is
+// rethrown on the calling thread once all workers have finished.
+template <typename Task>
+void parallelFor(size_t count, size_t max_threads, Task&& task) {
+    size_t thread_count = std::min(count, max_threads == 0 ? defaultThreadCount() : max_threads);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+    
+    auto worker = [&]() {
+        for (size_t i = next_index++; i < count; i = next_index++) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+        }
+    };
+    
+    // The calling thread takes part as one of the workers
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t t = 1; t < thread_count; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+} // namespace finance
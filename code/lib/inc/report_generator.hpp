@@ -1,5 +1,6 @@
 #pragma once
 
+#include "csv_writer.hpp"
 #include "finance_types.hpp"
 #include <string>
 #include <vector>
@@ -15,6 +16,10 @@ public:
     // Generate reports for the given expenses
     void generateReports(const std::vector<Expense>& expenses);
     
+    // Header and rows of categorised_transactions.csv
+    static void writeTransactionHeader(CsvWriter& writer);
+    static void writeTransactions(CsvWriter& writer, const std::vector<Expense>& expenses);
+    
 private:
     std::string output_dir_;
     
@@ -24,7 +29,7 @@ private:
     void generateFullReport(const std::vector<Expense>& expenses);
     
     // Calculate monthly totals by category
-    std::map<std::string, double> calculateCategoryTotals(
+    std::map<std::string, Money> calculateCategoryTotals(
         const std::vector<Expense>& expenses);
 };
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "csv_parser.hpp"
+#include "finance_types.hpp"
+#include "schema_registry.hpp"
+#include "transaction_parser.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace finance {
+
+// Built-in layout of a Monzo data export (18 columns)
+struct MonzoFormat {
+    static constexpr RowFormat ROW_FORMAT = RowFormat::Monzo;
+    static constexpr int DATE_COL = 1;
+    static constexpr int NAME_COL = 4;
+    static constexpr int AMOUNT_COL = 7;
+    static constexpr int CURRENCY_COL = 8;
+    static constexpr int DESCRIPTION_COL = 14;
+    static constexpr SignConvention SIGN = SignConvention::AsIs;
+    static constexpr DateFormat DATE_FORMAT = DateFormat::DayMonthYear;
+};
+
+// Built-in layout of an American Express export (5 columns). Amounts are
+// taken as-is: repayments are turned around by the credit card rule in
+// TransactionCategorisation, which expects the export's own sign.
+struct AmexFormat {
+    static constexpr RowFormat ROW_FORMAT = RowFormat::Amex;
+    static constexpr int DATE_COL = 0;
+    static constexpr int NAME_COL = -1;
+    static constexpr int AMOUNT_COL = 4;
+    static constexpr int CURRENCY_COL = -1;
+    static constexpr int DESCRIPTION_COL = 1;
+    static constexpr SignConvention SIGN = SignConvention::AsIs;
+    static constexpr DateFormat DATE_FORMAT = DateFormat::DayMonthYear;
+};
+
+// Decodes rows of a known format with its columns and conventions fixed at
+// compile time. Produces the same Expense as the generic profile-driven path
+// in DataLoader::createExpense for a profile with the same layout.
+template <typename Format>
+class RowDecoder {
+public:
+    // Fields that must be present in every row
+    static constexpr size_t REQUIRED_FIELDS =
+        static_cast<size_t>(std::max({Format::DATE_COL, Format::DESCRIPTION_COL,
+                                      Format::AMOUNT_COL})) + 1;
+
+    // Fields the tokenizer needs to split; later ones are never read
+    static constexpr size_t FIELD_LIMIT =
+        static_cast<size_t>(std::max({Format::DATE_COL, Format::DESCRIPTION_COL,
+                                      Format::AMOUNT_COL, Format::NAME_COL,
+                                      Format::CURRENCY_COL})) + 1;
+
+    // Whether a resolved profile has exactly this layout
+    static bool matches(const SchemaProfile& profile) {
+        return profile.cols.date_col == Format::DATE_COL &&
+               profile.cols.description_col == Format::DESCRIPTION_COL &&
+               profile.cols.amount_col == Format::AMOUNT_COL &&
+               profile.cols.name_col == Format::NAME_COL &&
+               profile.currency_col == Format::CURRENCY_COL &&
+               profile.sign == Format::SIGN &&
+               profile.date_format == Format::DATE_FORMAT;
+    }
+
+    static Expense decode(const CSVTokenizer& fields, Symbol file_origin) {
+        if (fields.size() < REQUIRED_FIELDS) {
+            throw std::runtime_error("Invalid number of fields");
+        }
+
+        Expense expense;
+        expense.date = TransactionParser::parseDate(fields[Format::DATE_COL], Format::DATE_FORMAT);
+        expense.file_origin = file_origin;
+        expense.currency = TransactionParser::normaliseDescription(
+            fields[Format::DESCRIPTION_COL], expense.description);
+
+        auto [amount, detected_currency] = TransactionParser::parseAmount(fields[Format::AMOUNT_COL]);
+        if constexpr (Format::SIGN == SignConvention::Negate) {
+            expense.amount = -amount;
+        } else {
+            expense.amount = amount;
+        }
+
+        Currency column_currency = Currency::UNKNOWN;
+        if constexpr (Format::CURRENCY_COL >= 0) {
+            if (fields.size() > static_cast<size_t>(Format::CURRENCY_COL)) {
+                column_currency = stringToCurrency(fields[Format::CURRENCY_COL]);
+            }
+        }
+        if (column_currency != Currency::UNKNOWN) {
+            expense.currency = column_currency;
+        } else if (expense.currency == Currency::UNKNOWN) {
+            expense.currency = detected_currency;
+        }
+
+        if constexpr (Format::NAME_COL >= 0) {
+            if (fields.size() > static_cast<size_t>(Format::NAME_COL)) {
+                expense.name = Symbol::intern(fields[Format::NAME_COL]);
+                if (expense.description.empty()) {
+                    expense.description = expense.name;
+                }
+            }
+        }
+
+        return expense;
+    }
+};
+
+} // namespace finance
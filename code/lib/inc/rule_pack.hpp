@@ -0,0 +1,83 @@
+#pragma once
+
+#include "keyword_matcher.hpp"
+#include "mapped_file.hpp"
+#include "string_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finance {
+
+// Hash identifying a set of keyword rules (keyword, category pairs in order)
+uint64_t keywordRulesFingerprint(const std::map<std::string, std::string>& keyword_map);
+
+// Keyword rules compiled to a binary pack (.pack): the matching automaton,
+// the keyword and category tables and a hash of the source keyword file.
+// The pack is memory-mapped read-only and matched in place, so processes
+// using the same pack share its pages and start without parsing or building
+// anything. Packs are host-local (native byte order).
+class RulePack {
+public:
+    static constexpr const char* FILE_EXTENSION = ".pack";
+
+    RulePack() = default;
+
+    RulePack(const RulePack&) = delete;
+    RulePack& operator=(const RulePack&) = delete;
+
+    // Build the automaton for keyword_map and serialise it with source_hash
+    static std::string compile(const std::map<std::string, std::string>& keyword_map,
+                               uint64_t source_hash);
+
+    // Write compiled bytes to a file, replacing it atomically
+    static void save(const std::string& filepath, const std::string& bytes);
+
+    // Map a pack; returns false (leaving the pack empty) if it is missing,
+    // corrupt, from another version or not built from source_hash
+    bool load(const std::string& filepath, uint64_t source_hash);
+
+    // Use compiled bytes held in memory, with the same checks as load()
+    bool assign(std::string bytes, uint64_t source_hash);
+
+    // Matcher over the pack's tables; the pack must outlive it
+    KeywordMatcher matcher() const;
+
+    // Keyword with a given rank (map order), and the rules as a map
+    std::string_view keyword(uint32_t rank) const { return keywords_[rank]; }
+    std::map<std::string, std::string> keywordMap() const;
+
+    size_t keywordCount() const { return keywords_.count; }
+    uint64_t rulesFingerprint() const { return rules_fingerprint_; }
+
+private:
+    // uint32 offsets[count + 1] followed by the bytes
+    struct StringTable {
+        const uint32_t* offsets = nullptr;
+        const char* bytes = nullptr;
+        uint32_t count = 0;
+
+        std::string_view operator[](uint32_t i) const {
+            return std::string_view(bytes + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+    };
+
+    // Check bytes_ and point the tables into it
+    bool open(uint64_t source_hash);
+    void clear();
+
+    MappedFile mapping_;
+    std::string owned_bytes_;           // Used when not mapped
+    std::string_view bytes_;
+
+    KeywordMatcher::Tables tables_{};
+    const uint32_t* rule_categories_ = nullptr;   // Category id by rank
+    StringTable keywords_;
+    StringTable categories_;
+    uint64_t rules_fingerprint_ = 0;
+};
+
+} // namespace finance
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include "transaction_categorisation.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace finance {
+
+// Per-rule hit counts and matching time gathered while categorising, for
+// finding keywords that never fire (and can be pruned) or fire the most.
+// Rules are identified by rank (map order). Not thread-safe; the categoriser
+// records into it from one thread.
+class RuleStats {
+public:
+    // Distinct example texts kept per rule
+    static constexpr size_t MAX_EXAMPLES = 3;
+
+    struct Rule {
+        size_t hits = 0;
+        size_t name_hits = 0;          // Hits on the name field
+        CivilDate first_match;         // Earliest and latest transaction dates
+        CivilDate last_match;
+        std::vector<Symbol> examples;  // Matched texts, in order of first hit
+    };
+
+    explicit RuleStats(size_t rule_count);
+
+    // Count one categorised row as decided by decideCategory()
+    void record(const CategoryDecision& decision, const Expense& expense);
+
+    // Add the time spent on a matching pass
+    void addMatchTime(std::chrono::steady_clock::duration elapsed);
+
+    const Rule& rule(uint32_t rank) const { return rules_[rank]; }
+    size_t ruleCount() const { return rules_.size(); }
+    size_t rows() const { return rows_; }
+    size_t uncategorised() const { return uncategorised_; }
+    size_t deadRules() const;
+    double matchSeconds() const;
+    double rowsPerSecond() const;
+
+    // One row per rule, dead rules included, named through categoriser
+    void writeCsv(const std::string& filepath,
+                  const TransactionCategorisation& categoriser) const;
+
+    // Row, rule and timing totals
+    void writeSummaryJson(const std::string& filepath) const;
+
+private:
+    std::vector<Rule> rules_;
+    size_t rows_ = 0;
+    size_t uncategorised_ = 0;
+    std::chrono::steady_clock::duration match_time_{};
+};
+
+} // namespace finance
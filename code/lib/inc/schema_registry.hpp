@@ -0,0 +1,66 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace finance {
+
+// How amounts in an export relate to spending (spending should end up negative)
+enum class SignConvention {
+    AsIs,   // Spending is already negative
+    Negate  // Spending is positive and must be flipped
+};
+
+// Row decoders specialised at compile time for built-in formats
+enum class RowFormat {
+    Generic,  // Columns read from the profile at run time
+    Monzo,    // RowDecoder<MonzoFormat>
+    Amex      // RowDecoder<AmexFormat>
+};
+
+// Column layout and conventions of one bank export, resolved once per file
+struct SchemaProfile {
+    std::string name;                       // Profile name, empty when guessed
+    CSVColumns cols;                        // Date, description, amount, name
+    int currency_col = -1;                  // Currency code column, if any
+    SignConvention sign = SignConvention::AsIs;
+    DateFormat date_format = DateFormat::DayMonthYear;
+    RowFormat row_format = RowFormat::Generic;  // Set when a built-in layout matches
+};
+
+// Known bank export formats keyed by a fingerprint of their header line.
+// Loaded from a CSV file with the columns:
+//   Profile,Fingerprint,DateColumn,DescriptionColumn,AmountColumn,
+//   NameColumn,CurrencyColumn,Sign,DateFormat
+// where Fingerprint is the hex of fingerprint(header), column numbers are
+// zero-based (-1 = absent), Sign is "as-is" or "negate" and DateFormat is
+// "dd/mm/yyyy" or "yyyy-mm-dd".
+class SchemaRegistry {
+public:
+    SchemaRegistry() = default;
+
+    // Load profiles from a file; throws std::runtime_error if it cannot be
+    // read or a row is malformed
+    void load(const std::string& filepath);
+
+    // Hash of a header line, ignoring case, quotes and whitespace
+    static uint64_t fingerprint(std::string_view header_line);
+
+    // Profile registered for a header fingerprint, or nullptr
+    const SchemaProfile* find(uint64_t header_fingerprint) const;
+
+    // Hash of the loaded file contents (0 when nothing is loaded), so caches
+    // built with one set of profiles are not reused with another
+    uint64_t contentHash() const { return content_hash_; }
+
+    size_t size() const { return profiles_.size(); }
+
+private:
+    std::unordered_map<uint64_t, SchemaProfile> profiles_;
+    uint64_t content_hash_ = 0;
+};
+
+} // namespace finance
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Interned string: a view of the pooled characters plus a 32-bit id. Symbols
+// from the same pool are equal exactly when their ids are, so grouping and
+// comparing them never touches the characters. Ids say nothing about order;
+// sort by view() where the output must be alphabetical.
+class Symbol {
+public:
+    // The empty string (id 0 in every pool)
+    constexpr Symbol() = default;
+
+    // Intern text in the process-wide pool
+    static Symbol intern(std::string_view text);
+
+    constexpr uint32_t id() const { return id_; }
+    constexpr std::string_view view() const { return std::string_view(data_, size_); }
+    std::string str() const { return std::string(data_, size_); }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+
+    constexpr bool operator==(Symbol other) const { return id_ == other.id_; }
+    constexpr bool operator!=(Symbol other) const { return id_ != other.id_; }
+
+private:
+    friend class StringPool;
+
+    constexpr Symbol(const char* data, uint32_t size, uint32_t id)
+        : data_(data), size_(size), id_(id) {}
+
+    const char* data_ = "";
+    uint32_t size_ = 0;
+    uint32_t id_ = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& out, Symbol symbol) {
+    return out << symbol.view();
+}
+
+// Set of distinct strings backed by an arena. Each string is copied once into
+// a block that is never moved or freed, so its Symbol stays valid for the
+// life of the pool. Interning may run on several threads.
+class StringPool {
+public:
+    StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Pool behind Symbol::intern; lives for the whole process
+    static StringPool& global();
+
+    // Symbol for text, copying it into the arena the first time it is seen;
+    // throws std::runtime_error if the pool runs out of ids
+    Symbol intern(std::string_view text);
+
+    size_t size() const;        // Distinct strings, including the empty one
+    size_t bytesUsed() const;   // Characters held in the arena
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t LARGE_STRING = BLOCK_SIZE / 4;  // Gets its own block
+
+    // Copy text into the arena (caller holds the write lock)
+    const char* store(std::string_view text);
+
+    mutable std::shared_mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;       // Free space in the current block
+    char* block_end_ = nullptr;
+    size_t bytes_used_ = 0;
+    std::unordered_map<std::string_view, Symbol> index_;  // Views into the arena
+};
+
+inline Symbol Symbol::intern(std::string_view text) {
+    return StringPool::global().intern(text);
+}
+
+} // namespace finance
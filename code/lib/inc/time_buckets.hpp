@@ -0,0 +1,125 @@
+#pragma once
+
+#include "finance_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// A way of dividing time into periods. Each period has an integer key that
+// orders like the periods and steps by one from each period to the next.
+struct Granularity {
+    enum class Unit {
+        Day,          // "YYYY-MM-DD"
+        Week,         // Week from first_weekday, labelled by its first day "YYYY-MM-DD"
+        IsoWeek,      // ISO 8601 week, "YYYY-Www"
+        Month,        // "YYYY-MM"
+        Quarter,      // "YYYY-Qn"
+        Year,         // "YYYY"
+        FiscalYear    // Year from start_month/start_day, "FYyyyy" by its first year
+    };
+
+    Unit unit = Unit::Month;
+    unsigned first_weekday = 0;   // Week: Monday = 0 ... Sunday = 6
+    unsigned start_month = 1;     // FiscalYear: first day of the year
+    unsigned start_day = 1;
+
+    static Granularity day() { return {Unit::Day}; }
+    static Granularity week(unsigned first_weekday = 0) { return {Unit::Week, first_weekday % 7}; }
+    static Granularity isoWeek() { return {Unit::IsoWeek}; }
+    static Granularity month() { return {Unit::Month}; }
+    static Granularity quarter() { return {Unit::Quarter}; }
+    static Granularity year() { return {Unit::Year}; }
+    static Granularity fiscalYear(unsigned start_month, unsigned start_day = 1) {
+        return {Unit::FiscalYear, 0, start_month, start_day};
+    }
+
+    int32_t key(CivilDate date) const;
+    std::string label(int32_t key) const;
+
+    bool operator==(const Granularity& other) const;
+    bool operator!=(const Granularity& other) const { return !(*this == other); }
+};
+
+// Category totals per period at several granularities, filled in one scan:
+// each row is looked up, converted and split into its periods once, then
+// written into a dense table per granularity (a row per category, found by
+// interned id, and a column per period key between the earliest and latest
+// seen). Cells, categories and periods count their rows, so a recategorised
+// row can be moved in place and periods without rows are left out.
+//
+// The tables can be saved and loaded again, keeping each cell's sum in
+// integer pence and its row count, so later runs can append rows to the
+// totals of earlier ones instead of summing every row again.
+class TimeBuckets {
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    explicit TimeBuckets(std::vector<Granularity> granularities = {});
+
+    size_t granularityCount() const { return tables_.size(); }
+    const Granularity& granularity(size_t index) const { return tables_[index].granularity; }
+
+    // Index of a granularity, or NOT_FOUND
+    size_t find(const Granularity& granularity) const;
+
+    // Size every table for the periods from first to last, so adds of dates
+    // in that range never have to grow them
+    void reserve(CivilDate first, CivilDate last);
+
+    // Add every expense in GBP (empty categories count as uncategorised)
+    void add(const std::vector<Expense>& expenses, Symbol uncategorised);
+
+    void add(Symbol category, CivilDate date, Money amount);
+
+    // Take back a row added earlier with the same arguments
+    void remove(Symbol category, CivilDate date, Money amount);
+
+    // Categories holding at least one row, in alphabetical order
+    std::vector<Symbol> categories() const;
+
+    // Keys of a granularity's periods holding at least one row, in order
+    std::vector<int32_t> periods(size_t index) const;
+
+    // Sum of one cell (zero when it has no rows)
+    Money total(size_t index, Symbol category, int32_t period) const;
+    
+    // Rows added to one cell
+    size_t rows(size_t index, Symbol category, int32_t period) const;
+    
+    // Write every table, tagged with fingerprint, replacing the file atomically
+    void save(const std::string& filepath, uint64_t fingerprint) const;
+    
+    // Replace the granularities and tables with saved ones; returns false
+    // (leaving these unchanged) if the file is missing, corrupt, from another
+    // version or was saved with another fingerprint
+    bool load(const std::string& filepath, uint64_t fingerprint);
+
+private:
+    struct Table {
+        Granularity granularity;
+        int32_t first_key = 0;            // Period key of column 0
+        size_t span = 0;                  // Columns per category row
+        std::vector<Money> cells;         // [slot * span + key - first_key]
+        std::vector<size_t> cell_rows;    // Rows per cell, indexed like cells
+        std::vector<size_t> period_rows;  // Rows per column
+
+        // Widen the period range to cover first..last
+        void grow(int32_t first, int32_t last, size_t category_count);
+    };
+
+    uint32_t slot(Symbol category);
+    
+    // Index of a cell in its table, or SIZE_MAX when it is outside
+    size_t cellIndex(const Table& table, Symbol category, int32_t period) const;
+
+    std::vector<Table> tables_;
+    std::vector<Symbol> categories_;               // By slot, in order of first appearance
+    std::vector<size_t> category_rows_;            // Rows per slot
+    std::unordered_map<uint32_t, uint32_t> slots_; // Category id -> slot
+};
+
+} // namespace finance
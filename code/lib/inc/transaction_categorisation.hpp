@@ -1,31 +1,111 @@
 #pragma once
 
 #include "finance_types.hpp"
+#include "keyword_matcher.hpp"
+#include "rule_pack.hpp"
+#include "category_memo.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
 
 namespace finance {
 
+class RuleStats;
+
+// Outcome counts of a categorisation pass
+struct CategorisationStats {
+    size_t matched = 0;         // Rows given a keyword category
+    size_t uncategorised = 0;   // Rows no keyword matched
+    size_t inverted = 0;        // Credit card repayments whose sign was flipped
+    size_t memo_hits = 0;       // Rows answered by the memo
+    
+    CategorisationStats& operator+=(const CategorisationStats& other) {
+        matched += other.matched;
+        uncategorised += other.uncategorised;
+        inverted += other.inverted;
+        memo_hits += other.memo_hits;
+        return *this;
+    }
+};
+
+// How one expense was categorised
+struct CategoryDecision {
+    static constexpr uint32_t NO_RULE = UINT32_MAX;
+    
+    uint32_t rule = NO_RULE; // Rank of the keyword that decided the category
+    bool by_name = false;    // Matched on the name field, not the description
+    bool inverted = false;   // Amount sign flipped as a credit card repayment
+};
+
 class TransactionCategorisation {
 public:
     // Constructor takes a map of keywords to categories
     explicit TransactionCategorisation(const std::map<std::string, std::string>& keyword_map);
     
+    // Use rules compiled into a pack, matching against its tables in place
+    explicit TransactionCategorisation(std::shared_ptr<const RulePack> rules);
+    
     // categorise a single expense based on its description
     void categoriseExpense(Expense& expense) const;
     
+    // categorise a single expense without consulting the memo, reporting
+    // the keyword that decided it
+    CategoryDecision decideCategory(Expense& expense) const;
+    
+    // Keyword with a given rank (map position)
+    std::string_view keyword(uint32_t rule) const {
+        return rules_ ? rules_->keyword(rule) : std::string_view(keywords_[rule]);
+    }
+    Symbol category(uint32_t rule) const { return matcher_.category(rule); }
+    size_t keywordCount() const { return matcher_.keywordCount(); }
+    
     // categorise a vector of expenses
     void categoriseExpenses(std::vector<Expense>& expenses) const;
     
+    // categorise a vector of expenses in contiguous shards on up to
+    // thread_count threads (0 = one per hardware thread). Rows are
+    // independent, so the result is identical to the serial overload.
+    CategorisationStats categoriseExpenses(std::vector<Expense>& expenses,
+                                           size_t thread_count) const;
+    
+    // Fingerprint of the keyword rules, for invalidating memoised results
+    uint64_t rulesFingerprint() const { return rules_fingerprint_; }
+    
+    // Consult and fill memo (built for rulesFingerprint()) while categorising;
+    // nullptr disables memoisation. The memo must outlive its use here.
+    void setMemo(CategoryMemo* memo);
+    
+    // Count the rule deciding each row, and time the matching passes of
+    // categoriseExpenses(), in rule_stats (sized to keywordCount()); nullptr
+    // disables collection. The memo is then only filled, never consulted, so
+    // every row is matched. The stats must outlive their use here.
+    void setRuleStats(RuleStats* rule_stats);
+    
 private:
-    std::map<std::string, std::string> keyword_map_;
+    std::shared_ptr<const RulePack> rules_;  // Keeps a pack's tables alive
+    KeywordMatcher matcher_;  // Keyword rules compiled once
+    std::vector<std::string> keywords_;   // Keyword by rank, unless in a pack
+    uint64_t rules_fingerprint_;
+    CategoryMemo* memo_ = nullptr;
+    RuleStats* rule_stats_ = nullptr;
+    Symbol credit_card_;      // Categories compared by id on every row
+    Symbol uncategorised_;
+    
+    // Categorise one expense and count the outcome in stats; the deciding
+    // rule is stored in decision when given (the memo is then bypassed)
+    void categorise(Expense& expense, CategorisationStats& stats,
+                    CategoryDecision* decision = nullptr) const;
     
     // Helper function to convert description to lowercase for matching
-    static std::string toLower(const std::string& str);
+    static std::string toLower(std::string_view str);
     
-    // Helper function to find matching category based on keywords
-    std::string findMatchingCategory(const std::string& description) const;
+    // Helper function to find the rank of the keyword deciding the category
+    // (NO_MATCH if none, or if its category is empty)
+    uint32_t findMatchingRule(std::string_view description) const;
 };
 
 } // namespace finance 
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 #include "finance_types.hpp"
 #include <string>
-#include <chrono>
+#include <string_view>
 #include <utility>
 
 namespace finance {
@@ -10,25 +10,31 @@ namespace finance {
 // Handles parsing and formatting of financial values
 class TransactionParser {
 public:
-    // Parse date string to time_point (format: DD/MM/YYYY)
-    static std::chrono::system_clock::time_point parseDate(const std::string& date_str);
+    // Parse a DD/MM/YYYY or YYYY-MM-DD date (1-2 digit day and month,
+    // anything after the date ignored); throws std::runtime_error if malformed
+    static CivilDate parseDate(std::string_view date_str,
+                               DateFormat format = DateFormat::DayMonthYear);
     
-    // Extract YYYY-MM format from time_point
-    static std::string extractMonth(const std::chrono::system_clock::time_point& date);
-    
-    // Parse amount string to double and detect currency
+    // Parse an amount field into exact minor units and detect its currency.
+    // Symbols, currency codes, quotes and thousands separators are ignored.
     // Returns pair of (amount, currency)
-    static std::pair<double, Currency> parseAmount(const std::string& amount_str);
+    static std::pair<Money, Currency> parseAmount(std::string_view amount_str);
+    
+    // Normalise a raw description field into out in a single pass: drop quotes,
+    // truncate at the first comma, remove standalone currency codes (GBR, GBP,
+    // EUR, USD), collapse whitespace runs to one space and trim.
+    // Returns the currency of the first code removed, or UNKNOWN.
+    static Currency normaliseDescription(std::string_view raw, std::string& out);
+    
+    // As above, interning the result
+    static Currency normaliseDescription(std::string_view raw, Symbol& out);
 
 private:
     // Parse currency type from amount string (symbols and codes)
-    static Currency parseCurrencyType(const std::string& amount_str);
-    
-    // Remove currency symbols from amount string
-    static std::string removeCurrencySymbols(const std::string& amount_str);
+    static Currency parseCurrencyType(std::string_view str);
     
-    // Remove numeric formatting from amount string
-    static std::string removeNumericFormatting(const std::string& amount_str);
+    // Remove whole words that are currency codes in place; returns new length
+    static size_t removeCurrencyCodes(char* str, size_t length);
 };
 
 } // namespace finance 
\ No newline at end of file
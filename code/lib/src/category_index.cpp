@@ -0,0 +1,210 @@
+#include "category_index.hpp"
+#include "keyword_matcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+
+namespace finance {
+
+CategoryIndex::CategoryIndex(std::vector<Expense> expenses,
+                             const std::map<std::string, std::string>& keyword_map,
+                             RuleStats* rule_stats)
+    : keyword_map_(keyword_map)
+    , expenses_(std::move(expenses))
+    , states_(expenses_.size())
+    , totals_({Granularity::month(), Granularity::week()}) {
+    if (expenses_.size() > UINT32_MAX) {
+        throw std::runtime_error("Too many expenses to index");
+    }
+    
+    if (!expenses_.empty()) {
+        auto [first, last] = std::minmax_element(expenses_.begin(), expenses_.end(),
+            [](const Expense& a, const Expense& b) { return a.date < b.date; });
+        totals_.reserve(first->date, last->date);
+    }
+    
+    TransactionCategorisation categoriser(keyword_map_);
+    rule_keywords_.assign(categoriser.keywordCount(), Symbol());
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t row = 0; row < expenses_.size(); ++row) {
+        Expense& expense = expenses_[row];
+        CategoryDecision decision = categoriser.decideCategory(expense);
+        states_[row].keyword = decidingKeyword(categoriser, decision);
+        states_[row].by_name = decision.by_name;
+        states_[row].inverted = decision.inverted;
+        link(row);
+        if (rule_stats) {
+            rule_stats->record(decision, expense);
+        }
+        
+        totals_.add(expense.category, expense.date, toGbp(expense.amount, expense.currency));
+    }
+    if (rule_stats) {
+        rule_stats->addMatchTime(std::chrono::steady_clock::now() - start);
+    }
+}
+
+bool CategoryIndex::hasEmptyCategory(const std::map<std::string, std::string>& keyword_map) {
+    return std::any_of(keyword_map.begin(), keyword_map.end(),
+                       [](const auto& rule) { return rule.second.empty(); });
+}
+
+Symbol CategoryIndex::decidingKeyword(const TransactionCategorisation& categoriser,
+                                      const CategoryDecision& decision) {
+    if (decision.rule == CategoryDecision::NO_RULE) {
+        return Symbol();
+    }
+    Symbol& keyword = rule_keywords_[decision.rule];
+    if (keyword.empty()) {
+        keyword = Symbol::intern(categoriser.keyword(decision.rule));
+    }
+    return keyword;
+}
+
+void CategoryIndex::link(uint32_t row) {
+    auto& rows = buckets_[bucketKey(states_[row])];
+    states_[row].slot = static_cast<uint32_t>(rows.size());
+    rows.push_back(row);
+}
+
+void CategoryIndex::unlink(uint32_t row) {
+    auto bucket = buckets_.find(bucketKey(states_[row]));
+    auto& rows = bucket->second;
+    
+    // Fill the gap with the bucket's last row
+    uint32_t last = rows.back();
+    rows[states_[row].slot] = last;
+    states_[last].slot = states_[row].slot;
+    rows.pop_back();
+    if (rows.empty()) {
+        buckets_.erase(bucket);
+    }
+}
+
+CategoryIndex::ReloadStats CategoryIndex::reload(
+    const std::map<std::string, std::string>& keyword_map) {
+    ReloadStats stats;
+    
+    // Diff the two maps in key order
+    std::map<std::string, std::string> added;
+    std::vector<Symbol> invalidated;   // Removed or re-categorised keywords
+    auto before = keyword_map_.begin();
+    auto after = keyword_map.begin();
+    while (before != keyword_map_.end() || after != keyword_map.end()) {
+        if (after == keyword_map.end() ||
+            (before != keyword_map_.end() && before->first < after->first)) {
+            ++stats.keywords_removed;
+            invalidated.push_back(Symbol::intern(before->first));
+            ++before;
+        } else if (before == keyword_map_.end() || after->first < before->first) {
+            ++stats.keywords_added;
+            added.insert(*after);
+            ++after;
+        } else {
+            if (before->second != after->second) {
+                ++stats.keywords_changed;
+                invalidated.push_back(Symbol::intern(before->first));
+            }
+            ++before;
+            ++after;
+        }
+    }
+    if (added.empty() && invalidated.empty()) {
+        return stats;
+    }
+    
+    // A keyword with an empty category counts as no match, letting later
+    // keywords or the name decide; the bucket rules above do not cover that
+    bool full_pass = hasEmptyCategory(keyword_map_) || hasEmptyCategory(keyword_map);
+    keyword_map_ = keyword_map;
+    TransactionCategorisation categoriser(keyword_map_);
+    rule_keywords_.assign(categoriser.keywordCount(), Symbol());
+    
+    std::vector<uint32_t> candidates;
+    if (full_pass) {
+        candidates.resize(expenses_.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    } else {
+        // Every row a dropped or re-categorised keyword decided
+        for (Symbol keyword : invalidated) {
+            for (bool by_name : {false, true}) {
+                RowState state;
+                state.keyword = keyword;
+                state.by_name = by_name;
+                auto bucket = buckets_.find(bucketKey(state));
+                if (bucket != buckets_.end()) {
+                    candidates.insert(candidates.end(), bucket->second.begin(), bucket->second.end());
+                }
+            }
+        }
+        
+        // Rows an added keyword can take over: it must occur in them, and
+        // they must be uncategorised, matched only on their name, or decided
+        // by a keyword that comes after it in map order
+        if (!added.empty()) {
+            KeywordMatcher added_matcher(added);
+            std::string_view first_added = added.begin()->first;
+            for (const auto& [key, rows] : buckets_) {
+                const RowState& state = states_[rows.front()];
+                if (!state.keyword.empty() && !state.by_name &&
+                    state.keyword.view() < first_added) {
+                    continue;
+                }
+                for (uint32_t row : rows) {
+                    const Expense& expense = expenses_[row];
+                    if (added_matcher.findRank(expense.description.view()) != KeywordMatcher::NO_MATCH ||
+                        (!expense.name.empty() &&
+                         added_matcher.findRank(expense.name.view()) != KeywordMatcher::NO_MATCH)) {
+                        candidates.push_back(row);
+                    }
+                }
+            }
+        }
+        
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+    
+    for (uint32_t row : candidates) {
+        recategorise(row, categoriser, stats);
+    }
+    return stats;
+}
+
+void CategoryIndex::recategorise(uint32_t row, const TransactionCategorisation& categoriser,
+                                 ReloadStats& stats) {
+    Expense& expense = expenses_[row];
+    RowState& state = states_[row];
+    const Symbol old_category = expense.category;
+    const Money old_amount = expense.amount;
+    
+    // Start again from the amount as parsed
+    if (state.inverted) {
+        expense.amount = -expense.amount;
+    }
+    CategoryDecision decision = categoriser.decideCategory(expense);
+    Symbol keyword = decidingKeyword(categoriser, decision);
+    ++stats.rows_checked;
+    
+    if (keyword != state.keyword || decision.by_name != state.by_name) {
+        unlink(row);
+        state.keyword = keyword;
+        state.by_name = decision.by_name;
+        link(row);
+    }
+    state.inverted = decision.inverted;
+    
+    if (expense.category == old_category && expense.amount == old_amount) {
+        return;
+    }
+    ++stats.rows_changed;
+    
+    // Move the row between summary cells
+    Money old_gbp = toGbp(old_amount, expense.currency);
+    Money new_gbp = toGbp(expense.amount, expense.currency);
+    totals_.remove(old_category, expense.date, old_gbp);
+    totals_.add(expense.category, expense.date, new_gbp);
+}
+
+} // namespace finance
@@ -0,0 +1,308 @@
+#include "category_memo.hpp"
+#include "hash_utils.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MEMO_MAGIC[8] = {'F', 'I', 'N', 'M', 'E', 'M', 'O', '1'};
+constexpr uint32_t MEMO_VERSION = 2;
+
+struct MemoHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t category_count;
+    uint64_t rules_fingerprint;
+    uint64_t slot_count;        // Power of two
+    uint64_t entry_count;
+    uint64_t keys_offset;       // After the category names
+    uint64_t keys_size;
+    uint64_t slots_offset;      // 8-byte aligned, after the key bytes
+    uint64_t file_size;
+    uint64_t checksum;          // FNV-1a of everything after the header
+};
+
+// Category names follow the header: uint32 offsets[count + 1], then bytes.
+// The key bytes of every entry come next, then the slots.
+
+} // namespace
+
+CategoryMemo::CategoryMemo(uint64_t rules_fingerprint)
+    : rules_fingerprint_(rules_fingerprint) {}
+
+uint64_t CategoryMemo::keyHash(std::string_view description, std::string_view name) {
+    uint64_t hash = fnv1a64(description);
+    hash = fnv1a64(std::string_view("\x1f", 1), hash);
+    return fnv1a64(name, hash);
+}
+
+bool CategoryMemo::keyMatches(std::string_view key, std::string_view description,
+                              std::string_view name) {
+    return key.size() == description.size() + 1 + name.size() &&
+           key.compare(0, description.size(), description) == 0 &&
+           key[description.size()] == '\x1f' &&
+           key.compare(description.size() + 1, name.size(), name) == 0;
+}
+
+const CategoryMemo::Slot* CategoryMemo::probe(uint64_t hash, std::string_view description,
+                                              std::string_view name) const {
+    if (loaded_slot_count_ == 0) {
+        return nullptr;
+    }
+    size_t mask = loaded_slot_count_ - 1;
+    for (size_t i = hash & mask, probes = 0; probes < loaded_slot_count_; i = (i + 1) & mask, ++probes) {
+        const Slot& slot = loaded_slots_[i];
+        if (slot.value == EMPTY_SLOT) {
+            return nullptr;
+        }
+        if (slot.key_hash == hash &&
+            keyMatches(loaded_keys_.substr(slot.key_offset, slot.key_length), description, name)) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+const CategoryMemo::Added* CategoryMemo::findAdded(uint64_t hash, std::string_view description,
+                                                   std::string_view name) const {
+    auto [begin, end] = added_.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (keyMatches(it->second.key, description, name)) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+bool CategoryMemo::load(const std::string& filepath) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    mapping_.close();
+    loaded_bytes_.clear();
+    loaded_slots_ = nullptr;
+    loaded_slot_count_ = 0;
+    loaded_keys_ = std::string_view();
+    loaded_entries_ = 0;
+    categories_.clear();
+    category_ids_.clear();
+    added_.clear();
+    
+    std::string_view bytes;
+    if (mapping_.open(filepath)) {
+        bytes = mapping_.view();
+    } else {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        loaded_bytes_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = loaded_bytes_;
+    }
+    
+    auto reject = [&] {
+        mapping_.close();
+        loaded_bytes_.clear();
+        categories_.clear();
+        category_ids_.clear();
+        return false;
+    };
+    
+    MemoHeader header;
+    if (bytes.size() < sizeof(header)) {
+        return reject();
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, MEMO_MAGIC, sizeof(MEMO_MAGIC)) != 0 ||
+        header.version != MEMO_VERSION ||
+        header.rules_fingerprint != rules_fingerprint_ ||
+        header.file_size != bytes.size() ||
+        header.slot_count == 0 || (header.slot_count & (header.slot_count - 1)) != 0 ||
+        header.slots_offset % alignof(Slot) != 0 ||
+        header.slots_offset > bytes.size() ||
+        header.keys_offset > header.slots_offset ||
+        header.keys_size > header.slots_offset - header.keys_offset ||
+        header.slot_count > (bytes.size() - header.slots_offset) / sizeof(Slot) ||
+        fnv1a64(bytes.substr(sizeof(header))) != header.checksum) {
+        return reject();
+    }
+    
+    // Category names
+    const uint64_t names_offset = sizeof(header);
+    const uint64_t offsets_bytes = sizeof(uint32_t) * (uint64_t{header.category_count} + 1);
+    if (names_offset + offsets_bytes > header.keys_offset) {
+        return reject();
+    }
+    const char* name_bytes = bytes.data() + names_offset + offsets_bytes;
+    const uint64_t name_bytes_size = header.keys_offset - names_offset - offsets_bytes;
+    for (uint32_t i = 0; i < header.category_count; ++i) {
+        uint32_t begin, end;
+        std::memcpy(&begin, bytes.data() + names_offset + sizeof(uint32_t) * i, sizeof(begin));
+        std::memcpy(&end, bytes.data() + names_offset + sizeof(uint32_t) * (i + 1), sizeof(end));
+        if (begin > end || end > name_bytes_size) {
+            return reject();
+        }
+        categories_.push_back(Symbol::intern(std::string_view(name_bytes + begin, end - begin)));
+        category_ids_.emplace(categories_.back().id(), i);
+    }
+    
+    loaded_slots_ = reinterpret_cast<const Slot*>(bytes.data() + header.slots_offset);
+    loaded_slot_count_ = header.slot_count;
+    loaded_keys_ = bytes.substr(header.keys_offset, header.keys_size);
+    
+    // Every occupied slot must name a known category and lie in the key bytes
+    for (size_t i = 0; i < loaded_slot_count_; ++i) {
+        const Slot& slot = loaded_slots_[i];
+        if (slot.value == EMPTY_SLOT) {
+            continue;
+        }
+        if ((slot.value >> 1) >= header.category_count ||
+            slot.key_offset > loaded_keys_.size() ||
+            slot.key_length > loaded_keys_.size() - slot.key_offset) {
+            loaded_slots_ = nullptr;
+            loaded_slot_count_ = 0;
+            loaded_keys_ = std::string_view();
+            loaded_entries_ = 0;
+            return reject();
+        }
+        ++loaded_entries_;
+    }
+    return true;
+}
+
+bool CategoryMemo::find(std::string_view description, std::string_view name, Entry& entry) const {
+    uint64_t hash = keyHash(description, name);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
+    uint32_t value;
+    if (const Slot* slot = probe(hash, description, name)) {
+        value = slot->value;
+    } else if (const Added* added = findAdded(hash, description, name)) {
+        value = added->value;
+    } else {
+        return false;
+    }
+    
+    entry.category = categories_[value >> 1];
+    entry.invert_amount = (value & 1) != 0;
+    return true;
+}
+
+uint32_t CategoryMemo::categoryId(Symbol category) {
+    auto it = category_ids_.find(category.id());
+    if (it != category_ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(categories_.size());
+    categories_.push_back(category);
+    category_ids_.emplace(category.id(), id);
+    return id;
+}
+
+void CategoryMemo::insert(std::string_view description, std::string_view name,
+                          Symbol category, bool invert_amount) {
+    uint64_t hash = keyHash(description, name);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (probe(hash, description, name)) {
+        return;
+    }
+    uint32_t value = (categoryId(category) << 1) | (invert_amount ? 1u : 0u);
+    for (auto [it, end] = added_.equal_range(hash); it != end; ++it) {
+        if (keyMatches(it->second.key, description, name)) {
+            it->second.value = value;
+            return;
+        }
+    }
+    std::string key;
+    key.reserve(description.size() + 1 + name.size());
+    key.append(description).append(1, '\x1f').append(name);
+    added_.emplace(hash, Added{std::move(key), value});
+}
+
+size_t CategoryMemo::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return loaded_entries_ + added_.size();
+}
+
+bool CategoryMemo::modified() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return !added_.empty();
+}
+
+void CategoryMemo::save(const std::string& filepath) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
+    // Size the table to stay at most half full
+    size_t entry_count = loaded_entries_ + added_.size();
+    size_t slot_count = 16;
+    while (slot_count < entry_count * 2) {
+        slot_count *= 2;
+    }
+    std::vector<Slot> slots(slot_count, Slot{0, 0, 0, EMPTY_SLOT});
+    std::string keys;
+    auto place = [&](uint64_t hash, std::string_view key, uint32_t value) {
+        size_t mask = slot_count - 1;
+        size_t i = hash & mask;
+        while (slots[i].value != EMPTY_SLOT) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = Slot{hash, keys.size(), static_cast<uint32_t>(key.size()), value};
+        keys.append(key);
+    };
+    for (size_t i = 0; i < loaded_slot_count_; ++i) {
+        const Slot& slot = loaded_slots_[i];
+        if (slot.value != EMPTY_SLOT) {
+            place(slot.key_hash, loaded_keys_.substr(slot.key_offset, slot.key_length), slot.value);
+        }
+    }
+    for (const auto& [hash, entry] : added_) {
+        place(hash, entry.key, entry.value);
+    }
+    
+    MemoHeader header = {};
+    std::memcpy(header.magic, MEMO_MAGIC, sizeof(MEMO_MAGIC));
+    header.version = MEMO_VERSION;
+    header.category_count = static_cast<uint32_t>(categories_.size());
+    header.rules_fingerprint = rules_fingerprint_;
+    header.slot_count = slot_count;
+    header.entry_count = entry_count;
+    
+    std::string out(sizeof(header), '\0');
+    uint32_t offset = 0;
+    out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    for (const auto& category : categories_) {
+        offset += static_cast<uint32_t>(category.size());
+        out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    for (const auto& category : categories_) {
+        out.append(category.view().data(), category.size());
+    }
+    header.keys_offset = out.size();
+    header.keys_size = keys.size();
+    out.append(keys);
+    out.resize((out.size() + alignof(Slot) - 1) & ~(alignof(Slot) - 1), '\0');
+    header.slots_offset = out.size();
+    out.append(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(Slot));
+    header.file_size = out.size();
+    header.checksum = fnv1a64(std::string_view(out).substr(sizeof(header)));
+    std::memcpy(&out[0], &header, sizeof(header));
+    
+    // Write to a temporary file first so readers never see a torn table
+    std::string temp_path = filepath + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    fs::rename(temp_path, filepath);
+}
+
+} // namespace finance
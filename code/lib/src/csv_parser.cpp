@@ -1,12 +1,96 @@
 #include "csv_parser.hpp"
 #include <algorithm>
-#include <sstream>
+#include <cctype>
+#include <cstring>
 
 namespace finance {
 
-CSVColumns CSVParser::parseHeader(const std::string& header_line) {
+namespace {
+
+inline bool isTrimmable(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+size_t CSVTokenizer::tokenize(std::string_view line, size_t max_fields) {
+    offsets_.clear();
+    
+    // Fields are plain slices of the line until a quote is seen; after that
+    // the line is copied into the reusable buffer with quote characters dropped
+    const char* src = line.data();
+    const uint32_t length = static_cast<uint32_t>(line.size());
+    data_ = src;
+    bool copying = false;
+    uint32_t start = 0;   // Start of the current field in output coordinates
+    uint32_t out = 0;     // Bytes written to buffer_ while copying
+    uint32_t cursor = 0;  // Next input byte still to be copied
+    uint64_t in_quotes = 0;  // All ones when the previous block ended inside quotes
+    
+    for (uint32_t base = 0; base < length; base += CSVScanner::BLOCK_SIZE) {
+        StructuralMasks masks = scanner_.scanBlock(src + base, length - base);
+        uint64_t quoted = CSVScanner::prefixXor(masks.quote) ^ in_quotes;
+        in_quotes = (quoted >> 63) ? ~uint64_t{0} : 0;
+        uint64_t separators = masks.comma & ~quoted;
+        
+        if (!copying && masks.quote) {
+            copying = true;
+            buffer_.resize(length);
+            data_ = buffer_.data();
+            std::memcpy(buffer_.data(), src, base);
+            out = cursor = base;
+        }
+        
+        if (!copying) {
+            for (; separators; separators &= separators - 1) {
+                uint32_t pos = base + static_cast<uint32_t>(CSVScanner::countTrailingZeros(separators));
+                addField(start, pos);
+                if (offsets_.size() == max_fields) {
+                    return max_fields;
+                }
+                start = pos + 1;
+            }
+            continue;
+        }
+        
+        // Copy the runs between quotes and separators, splitting on separators
+        for (uint64_t events = separators | masks.quote; events; events &= events - 1) {
+            uint64_t bit = events & (~events + 1);
+            uint32_t pos = base + static_cast<uint32_t>(CSVScanner::countTrailingZeros(events));
+            std::memcpy(buffer_.data() + out, src + cursor, pos - cursor);
+            out += pos - cursor;
+            cursor = pos + 1;
+            if (separators & bit) {
+                addField(start, out);
+                if (offsets_.size() == max_fields) {
+                    return max_fields;
+                }
+                start = out;
+            }
+        }
+    }
+    
+    if (copying) {
+        std::memcpy(buffer_.data() + out, src + cursor, length - cursor);
+        out += length - cursor;
+        addField(start, out);
+    } else {
+        addField(start, length);
+    }
+    return offsets_.size();
+}
+
+void CSVTokenizer::addField(uint32_t begin, uint32_t end) {
+    // Remove leading/trailing whitespace
+    while (begin < end && isTrimmable(data_[begin])) ++begin;
+    while (end > begin && isTrimmable(data_[end - 1])) --end;
+    offsets_.push_back({begin, end});
+}
+
+CSVColumns CSVParser::parseHeader(std::string_view header_line) {
     CSVColumns cols;
-    std::vector<std::string> fields = parseLine(header_line);
+    CSVTokenizer fields;
+    fields.tokenize(header_line);
     
     // Find column indices based on header names
     for (size_t i = 0; i < fields.size(); ++i) {
@@ -29,43 +113,9 @@ CSVColumns CSVParser::parseHeader(const std::string& header_line) {
     return cols;
 }
 
-std::vector<std::string> CSVParser::parseLine(const std::string& line) {
-    std::vector<std::string> fields;
-    bool in_quotes = false;
-    std::string current_field;
-    
-    // Parse character by character, handling quoted fields
-    for (size_t i = 0; i < line.length(); ++i) {
-        char c = line[i];
-        
-        if (c == '"') {
-            in_quotes = !in_quotes;
-            // Skip adding the quote character
-            continue;
-        }
-        
-        if (c == ',' && !in_quotes) {
-            // Remove leading/trailing whitespace
-            current_field.erase(0, current_field.find_first_not_of(" \t\r\n"));
-            current_field.erase(current_field.find_last_not_of(" \t\r\n") + 1);
-            fields.push_back(current_field);
-            current_field.clear();
-        } else {
-            current_field += c;
-        }
-    }
-    
-    // Add the last field after trimming whitespace
-    current_field.erase(0, current_field.find_first_not_of(" \t\r\n"));
-    current_field.erase(current_field.find_last_not_of(" \t\r\n") + 1);
-    fields.push_back(current_field);
-    
-    return fields;
-}
-
-std::string CSVParser::cleanField(const std::string& field) {
+std::string CSVParser::cleanField(std::string_view field) {
     // Convert to lowercase for case-insensitive matching
-    std::string cleaned = field;
+    std::string cleaned(field);
     std::transform(cleaned.begin(), cleaned.end(), cleaned.begin(), ::tolower);
     
     return removeQuotesAndWhitespace(cleaned);
@@ -85,4 +135,4 @@ std::string CSVParser::removeQuotesAndWhitespace(const std::string& field) {
     return cleaned;
 }
 
-} // namespace finance 
\ No newline at end of file
+} // namespace finance
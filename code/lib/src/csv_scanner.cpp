@@ -0,0 +1,157 @@
+#include "csv_scanner.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FINANCE_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace finance {
+
+namespace {
+
+StructuralMasks scanBlockScalar(const char* block) {
+    StructuralMasks masks;
+    for (size_t i = 0; i < CSVScanner::BLOCK_SIZE; ++i) {
+        uint64_t bit = uint64_t{1} << i;
+        switch (block[i]) {
+            case ',':  masks.comma |= bit; break;
+            case '"':  masks.quote |= bit; break;
+            case '\n': masks.newline |= bit; break;
+            default: break;
+        }
+    }
+    return masks;
+}
+
+#ifdef FINANCE_SCAN_X86
+
+StructuralMasks scanBlockSSE2(const char* block) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    
+    StructuralMasks masks;
+    for (size_t offset = 0; offset < CSVScanner::BLOCK_SIZE; offset += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset));
+        uint32_t comma_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma)));
+        uint32_t quote_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)));
+        uint32_t newline_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        masks.comma |= static_cast<uint64_t>(comma_bits) << offset;
+        masks.quote |= static_cast<uint64_t>(quote_bits) << offset;
+        masks.newline |= static_cast<uint64_t>(newline_bits) << offset;
+    }
+    return masks;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FINANCE_SCAN_AVX2 1
+
+__attribute__((target("avx2")))
+StructuralMasks scanBlockAVX2(const char* block) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    
+    StructuralMasks masks;
+    for (size_t offset = 0; offset < CSVScanner::BLOCK_SIZE; offset += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + offset));
+        uint32_t comma_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, comma)));
+        uint32_t quote_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)));
+        uint32_t newline_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        masks.comma |= static_cast<uint64_t>(comma_bits) << offset;
+        masks.quote |= static_cast<uint64_t>(quote_bits) << offset;
+        masks.newline |= static_cast<uint64_t>(newline_bits) << offset;
+    }
+    return masks;
+}
+
+#endif // __GNUC__ || __clang__
+#endif // FINANCE_SCAN_X86
+
+} // namespace
+
+CSVScanner::CSVScanner(ScanKernel kernel)
+    : kernel_(isSupported(kernel) ? kernel : ScanKernel::Scalar)
+    , scan_block_(scanBlockScalar) {
+#ifdef FINANCE_SCAN_X86
+    if (kernel_ == ScanKernel::SSE2) {
+        scan_block_ = scanBlockSSE2;
+    }
+#ifdef FINANCE_SCAN_AVX2
+    if (kernel_ == ScanKernel::AVX2) {
+        scan_block_ = scanBlockAVX2;
+    }
+#endif
+#endif
+}
+
+StructuralMasks CSVScanner::scanBlock(const char* data, size_t length) const {
+    if (length >= BLOCK_SIZE) {
+        return scan_block_(data);
+    }
+    
+    // Pad short tails so the vector kernels never read past the input
+    char padded[BLOCK_SIZE] = {};
+    std::memcpy(padded, data, length);
+    return scan_block_(padded);
+}
+
+size_t CSVScanner::findRecordEnd(const char* data, size_t length, bool& in_quotes) const {
+    for (size_t base = 0; base < length; base += BLOCK_SIZE) {
+        StructuralMasks masks = scanBlock(data + base, length - base);
+        uint64_t quoted = prefixXor(masks.quote) ^ (in_quotes ? ~uint64_t{0} : 0);
+        uint64_t record_ends = masks.newline & ~quoted;
+        if (record_ends) {
+            in_quotes = false;
+            return base + countTrailingZeros(record_ends);
+        }
+        in_quotes ^= (popCount(masks.quote) & 1) != 0;
+    }
+    return length;
+}
+
+size_t CSVScanner::countQuotes(const char* data, size_t length) const {
+    size_t count = 0;
+    for (size_t base = 0; base < length; base += BLOCK_SIZE) {
+        count += popCount(scanBlock(data + base, length - base).quote);
+    }
+    return count;
+}
+
+ScanKernel CSVScanner::bestKernel() {
+    static const ScanKernel best = [] {
+        if (isSupported(ScanKernel::AVX2)) return ScanKernel::AVX2;
+        if (isSupported(ScanKernel::SSE2)) return ScanKernel::SSE2;
+        return ScanKernel::Scalar;
+    }();
+    return best;
+}
+
+bool CSVScanner::isSupported(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Scalar:
+            return true;
+#ifdef FINANCE_SCAN_X86
+        case ScanKernel::SSE2:
+            return true;
+#ifdef FINANCE_SCAN_AVX2
+        case ScanKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* CSVScanner::kernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Scalar: return "scalar";
+        case ScanKernel::SSE2: return "sse2";
+        case ScanKernel::AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+} // namespace finance
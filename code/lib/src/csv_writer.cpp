@@ -0,0 +1,201 @@
+#include "csv_writer.hpp"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace finance {
+
+CsvWriter::CsvWriter(const std::string& filepath, Mode mode, bool background_flush,
+                     size_t buffer_size)
+    : filepath_(filepath)
+    , buffer_(buffer_size == 0 ? DEFAULT_BUFFER_SIZE : buffer_size)
+    , background_(background_flush) {
+    file_ = std::fopen(filepath.c_str(), mode == Mode::Append ? "ab" : "wb");
+    if (!file_) {
+        throw std::runtime_error("Could not create file: " + filepath);
+    }
+
+    // Buffers are written whole, so the stream needs no buffer of its own
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    if (background_) {
+        pending_.resize(buffer_.size());
+        flusher_ = std::thread([this] { flushLoop(); });
+    }
+}
+
+CsvWriter::~CsvWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+char* CsvWriter::beginField(size_t bytes) {
+    bytes += row_started_ ? 1 : 0;
+    if (used_ + bytes > buffer_.size()) {
+        flush();
+        if (bytes > buffer_.size()) {
+            buffer_.resize(bytes);
+        }
+    }
+
+    char* out = buffer_.data() + used_;
+    if (row_started_) {
+        *out++ = ',';
+    }
+    row_started_ = true;
+    return out;
+}
+
+bool CsvWriter::needsQuotes(std::string_view text) {
+    for (char c : text) {
+        if (c == ',' || c == '"' || c == '\n' || c == '\r') {
+            return true;
+        }
+    }
+    return false;
+}
+
+CsvWriter& CsvWriter::field(std::string_view text) {
+    return needsQuotes(text) ? quotedField(text) : plainField(text);
+}
+
+CsvWriter& CsvWriter::field(Symbol text) {
+    // Symbols repeat across rows, so each is scanned for quoting only once
+    if (text.id() >= symbol_quoting_.size()) {
+        symbol_quoting_.resize(static_cast<size_t>(text.id()) + 1, 0);
+    }
+    uint8_t& quoting = symbol_quoting_[text.id()];
+    if (quoting == 0) {
+        quoting = needsQuotes(text.view()) ? QUOTED : PLAIN;
+    }
+    return quoting == PLAIN ? plainField(text.view()) : quotedField(text.view());
+}
+
+CsvWriter& CsvWriter::plainField(std::string_view text) {
+    char* out = beginField(text.size());
+    std::memcpy(out, text.data(), text.size());
+    used_ = static_cast<size_t>(out + text.size() - buffer_.data());
+    return *this;
+}
+
+CsvWriter& CsvWriter::quotedField(std::string_view text) {
+    // Double any quotes inside the field
+    char* out = beginField(text.size() * 2 + 2);
+    *out++ = '"';
+    for (char c : text) {
+        if (c == '"') {
+            *out++ = '"';
+        }
+        *out++ = c;
+    }
+    *out++ = '"';
+    used_ = static_cast<size_t>(out - buffer_.data());
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(Money amount) {
+    char* out = beginField(Money::MAX_CHARS);
+    used_ = static_cast<size_t>(amount.toChars(out) - buffer_.data());
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(int64_t value) {
+    constexpr size_t MAX_DIGITS = 20;   // Sign and 19 digits
+    char* out = beginField(MAX_DIGITS);
+    used_ = static_cast<size_t>(std::to_chars(out, out + MAX_DIGITS, value).ptr - buffer_.data());
+    return *this;
+}
+
+CsvWriter& CsvWriter::dayMonthYearField(CivilDate date) {
+    char* out = beginField(10);
+    used_ = static_cast<size_t>(date.writeDayMonthYear(out) - buffer_.data());
+    return *this;
+}
+
+CsvWriter& CsvWriter::monthField(CivilDate date) {
+    char* out = beginField(7);
+    used_ = static_cast<size_t>(CivilDate::writeMonthKey(out, date.monthKey()) - buffer_.data());
+    return *this;
+}
+
+void CsvWriter::endRow() {
+    if (used_ == buffer_.size()) {
+        flush();
+    }
+    buffer_[used_++] = '\n';
+    row_started_ = false;
+}
+
+bool CsvWriter::writeOut(const char* data, size_t size) {
+    return std::fwrite(data, 1, size, file_) == size;
+}
+
+void CsvWriter::flush() {
+    if (used_ == 0 || !file_) {
+        return;
+    }
+
+    if (!background_) {
+        failed_ = !writeOut(buffer_.data(), used_) || failed_;
+        used_ = 0;
+        return;
+    }
+
+    // Wait for the previous buffer to be written, then swap this one in
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [&] { return !has_pending_; });
+    if (pending_.size() < buffer_.size()) {
+        pending_.resize(buffer_.size());
+    }
+    buffer_.swap(pending_);
+    pending_size_ = used_;
+    has_pending_ = true;
+    used_ = 0;
+    changed_.notify_all();
+}
+
+void CsvWriter::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        changed_.wait(lock, [&] { return has_pending_ || stopping_; });
+        if (!has_pending_) {
+            return;
+        }
+
+        // Write without holding the lock so the next buffer keeps filling
+        lock.unlock();
+        bool written = writeOut(pending_.data(), pending_size_);
+        lock.lock();
+        failed_ = !written || failed_;
+        has_pending_ = false;
+        changed_.notify_all();
+    }
+}
+
+void CsvWriter::close() {
+    if (!file_) {
+        return;
+    }
+
+    flush();
+    if (flusher_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        flusher_.join();
+    }
+
+    bool failed = std::fclose(file_) != 0 || failed_;
+    file_ = nullptr;
+    if (failed) {
+        throw std::runtime_error("Could not write file: " + filepath_);
+    }
+}
+
+} // namespace finance
@@ -1,12 +1,10 @@
 #include "data_exporter.hpp"
+#include "transaction_parser.hpp"
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <map>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
-#include <set>
 #include <algorithm>
 
 namespace finance {
@@ -18,183 +16,203 @@ DataExporter::DataExporter(const std::string& output_dir,
                          bool export_weekly,
                          bool export_entire)
     : output_dir_(output_dir)
-    , export_monthly_(export_monthly)
-    , export_weekly_(export_weekly)
+    , uncategorised_(Symbol::intern("Uncategorised"))
     , export_entire_(export_entire) {
+    if (export_monthly) {
+        summaries_.push_back({Granularity::month(), "monthly_summary.csv"});
+    }
+    if (export_weekly) {
+        summaries_.push_back({Granularity::week(), "weekly_summary.csv"});
+    }
+    
     // Create output directory if it doesn't exist
     fs::create_directories(output_dir);
 }
 
+void DataExporter::addSummary(const Granularity& granularity, const std::string& filename) {
+    summaries_.push_back({granularity, filename});
+}
+
 void DataExporter::exportData(const std::vector<Expense>& expenses) {
-    if (!export_monthly_ && !export_weekly_ && !export_entire_) {
+    if (summaries_.empty() && !export_entire_) {
         std::cerr << "Warning: No export flags set. No files will be generated.\n";
         return;
     }
 
-    if (export_monthly_) {
-        exportMonthlyData(expenses);
+    begin();
+    add(expenses);
+    finish();
+}
+
+void DataExporter::exportData(const std::vector<Expense>& expenses, const TimeBuckets& totals) {
+    if (summaries_.empty() && !export_entire_) {
+        std::cerr << "Warning: No export flags set. No files will be generated.\n";
+        return;
     }
-    if (export_weekly_) {
-        exportWeeklyData(expenses);
+    
+    begin();
+    add(expenses);
+    for (const auto& summary : summaries_) {
+        size_t index = totals.find(summary.granularity);
+        writeSummary(index != TimeBuckets::NOT_FOUND ? summaryTable(totals, index)
+                                                     : summaryTable(*cube_, summary.granularity),
+                     summary.filename);
     }
-    if (export_entire_) {
-        exportEntireData(expenses);
+    if (entire_file_) {
+        entire_file_->close();
+        entire_file_.reset();
     }
 }
 
-void DataExporter::exportMonthlyData(const std::vector<Expense>& expenses) {
-    // Get all unique categories and months
-    std::set<std::string> categories;
-    std::map<std::string, std::map<std::string, double>> category_month_totals;
-    std::vector<std::string> months;
-    
-    for (const auto& expense : expenses) {
-        // Use "Uncategorised" for empty categories
-        std::string category = expense.category.empty() ? "Uncategorised" : expense.category;
-        categories.insert(category);
-        
-        // Convert to GBP if necessary
-        double amount_gbp = expense.amount;
-        if (expense.currency == Currency::EUR) {
-            amount_gbp *= 0.86;  // Approximate EUR to GBP conversion
-        } else if (expense.currency == Currency::USD) {
-            amount_gbp *= 0.79;  // Approximate USD to GBP conversion
-        }
-        
-        category_month_totals[category][expense.month] += amount_gbp;
-        
-        // Keep track of months in order of appearance
-        if (std::find(months.begin(), months.end(), expense.month) == months.end()) {
-            months.push_back(expense.month);
+TimeBuckets DataExporter::summaryTotals(const std::vector<Expense>& expenses) const {
+    std::vector<Granularity> granularities;
+    for (const auto& summary : summaries_) {
+        granularities.push_back(summary.granularity);
+    }
+    TimeBuckets totals(std::move(granularities));
+    totals.add(expenses, uncategorised_);
+    return totals;
+}
+
+bool DataExporter::appendData(const std::vector<Expense>& expenses, TimeBuckets& totals,
+                              std::shared_ptr<ExpenseCube> cube) {
+    std::vector<size_t> indices;
+    for (const auto& summary : summaries_) {
+        size_t index = totals.find(summary.granularity);
+        if (index == TimeBuckets::NOT_FOUND) {
+            return false;
         }
+        indices.push_back(index);
     }
-    
-    // Sort months chronologically
-    std::sort(months.begin(), months.end());
-    
-    // Create the monthly summary file
-    std::string filepath = fs::path(output_dir_) / "monthly_summary.csv";
-    std::ofstream file(filepath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not create file: " + filepath);
+    cube_ = std::move(cube);
+    if (expenses.empty()) {
+        return true;
     }
     
-    // Write header with months
-    file << "Category";
-    for (const auto& month : months) {
-        file << "," << month;
+    // A summary file changes when a row moves a total or brings in a
+    // category or period it did not show before
+    const bool totals_moved = std::any_of(expenses.begin(), expenses.end(), [](const Expense& expense) {
+        return toGbp(expense.amount, expense.currency) != Money();
+    });
+    const std::vector<Symbol> categories = totals.categories();
+    std::vector<std::vector<int32_t>> periods;
+    for (size_t index : indices) {
+        periods.push_back(totals.periods(index));
     }
-    file << "\n";
     
-    // Write data for each category
-    for (const auto& category : categories) {
-        file << category;
-        for (const auto& month : months) {
-            double total = category_month_totals[category][month];
-            file << "," << std::fixed << std::setprecision(2) << total;
+    totals.add(expenses, uncategorised_);
+    cube_->add(expenses, uncategorised_);
+    
+    const bool categories_changed = totals.categories() != categories;
+    for (size_t i = 0; i < summaries_.size(); ++i) {
+        if (totals_moved || categories_changed || totals.periods(indices[i]) != periods[i]) {
+            writeSummary(summaryTable(totals, indices[i]), summaries_[i].filename);
         }
-        file << "\n";
     }
+    
+    if (export_entire_) {
+        std::string filepath = fs::path(output_dir_) / "categorised_transactions.csv";
+        CsvWriter writer(filepath, CsvWriter::Mode::Append);
+        ReportGenerator::writeTransactions(writer, expenses);
+        writer.close();
+    }
+    return true;
 }
 
-void DataExporter::exportWeeklyData(const std::vector<Expense>& expenses) {
-    // Get all unique categories and weeks
-    std::set<std::string> categories;
-    std::map<std::string, std::map<std::string, double>> category_week_totals;
-    std::vector<std::string> weeks;
+void DataExporter::begin() {
+    cube_ = std::make_shared<ExpenseCube>();
     
-    for (const auto& expense : expenses) {
-        // Get the start of the week (Monday) for this expense
-        auto time = std::chrono::system_clock::to_time_t(expense.date);
-        std::tm tm = *std::localtime(&time);
-        
-        // Calculate days to subtract to get to Monday (tm_wday is 0-based, Sunday = 0)
-        int days_to_monday = (tm.tm_wday == 0) ? 6 : tm.tm_wday - 1;
-        
-        // Subtract days to get to Monday
-        tm.tm_mday -= days_to_monday;
-        std::mktime(&tm);  // Normalize the time
-        
-        // Format the week start date
-        char buffer[11];
-        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
-        std::string week_key = buffer;
-        
-        // Use "Uncategorised" for empty categories
-        std::string category = expense.category.empty() ? "Uncategorised" : expense.category;
-        categories.insert(category);
-        
-        // Convert to GBP if necessary
-        double amount_gbp = expense.amount;
-        if (expense.currency == Currency::EUR) {
-            amount_gbp *= 0.86;
-        } else if (expense.currency == Currency::USD) {
-            amount_gbp *= 0.79;
-        }
-        
-        category_week_totals[category][week_key] += amount_gbp;
-        
-        // Keep track of weeks in order of appearance
-        if (std::find(weeks.begin(), weeks.end(), week_key) == weeks.end()) {
-            weeks.push_back(week_key);
+    if (export_entire_) {
+        std::string filepath = fs::path(output_dir_) / "categorised_transactions.csv";
+        entire_file_ = std::make_unique<CsvWriter>(filepath, CsvWriter::Mode::Truncate, true);
+        ReportGenerator::writeTransactionHeader(*entire_file_);
+    }
+}
+
+void DataExporter::add(const std::vector<Expense>& expenses) {
+    cube_->add(expenses, uncategorised_);
+    if (entire_file_) {
+        ReportGenerator::writeTransactions(*entire_file_, expenses);
+    }
+}
+
+void DataExporter::finish() {
+    for (const auto& summary : summaries_) {
+        writeSummary(summaryTable(*cube_, summary.granularity), summary.filename);
+    }
+    if (entire_file_) {
+        entire_file_->close();
+        entire_file_.reset();
+    }
+}
+
+DataExporter::SummaryTable DataExporter::summaryTable(const TimeBuckets& totals, size_t index) {
+    SummaryTable table;
+    const Granularity& granularity = totals.granularity(index);
+    std::vector<int32_t> periods = totals.periods(index);
+    for (int32_t period : periods) {
+        table.periods.push_back(granularity.label(period));
+    }
+    table.categories = totals.categories();
+    for (Symbol category : table.categories) {
+        for (int32_t period : periods) {
+            table.totals.push_back(totals.total(index, category, period));
         }
     }
+    return table;
+}
+
+DataExporter::SummaryTable DataExporter::summaryTable(const ExpenseCube& cube,
+                                                      const Granularity& granularity) {
+    // Cells come sorted by category, then period
+    auto cells = cube.query(ExpenseCube::CATEGORY | ExpenseCube::PERIOD, granularity);
     
-    // Sort weeks chronologically
-    std::sort(weeks.begin(), weeks.end());
-    
-    // Create the weekly summary file
-    std::string filepath = fs::path(output_dir_) / "weekly_summary.csv";
-    std::ofstream file(filepath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not create file: " + filepath);
+    std::vector<int32_t> periods;
+    for (const auto& cell : cells) {
+        periods.push_back(cell.period);
     }
+    std::sort(periods.begin(), periods.end());
+    periods.erase(std::unique(periods.begin(), periods.end()), periods.end());
     
-    // Write header with weeks
-    file << "Category";
-    for (const auto& week : weeks) {
-        file << "," << week;
+    SummaryTable table;
+    for (int32_t period : periods) {
+        table.periods.push_back(granularity.label(period));
     }
-    file << "\n";
-    
-    // Write data for each category
-    for (const auto& category : categories) {
-        file << category;
-        for (const auto& week : weeks) {
-            double total = category_week_totals[category][week];
-            file << "," << std::fixed << std::setprecision(2) << total;
+    for (const auto& cell : cells) {
+        if (table.categories.empty() || table.categories.back() != cell.category) {
+            table.categories.push_back(cell.category);
+            table.totals.resize(table.totals.size() + periods.size());
         }
-        file << "\n";
+        size_t column = std::lower_bound(periods.begin(), periods.end(), cell.period) - periods.begin();
+        table.totals[(table.categories.size() - 1) * periods.size() + column] = cell.measures.sum;
     }
+    return table;
 }
 
-void DataExporter::exportEntireData(const std::vector<Expense>& expenses) {
-    std::string filepath = fs::path(output_dir_) / "categorised_transactions.csv";
+void DataExporter::writeSummary(const SummaryTable& table, const std::string& filename) {
+    // Create the summary file
+    std::string filepath = fs::path(output_dir_) / filename;
     std::ofstream file(filepath);
-    
     if (!file.is_open()) {
         throw std::runtime_error("Could not create file: " + filepath);
     }
     
-    // Write header
-    file << "Date,Month,FileOrigin,Description,Amount,Currency,Category\n";
+    // Write header with periods
+    file << "Category";
+    for (const auto& period : table.periods) {
+        file << "," << period;
+    }
+    file << "\n";
     
-    // Write expenses
-    for (const auto& expense : expenses) {
-        // Format date
-        auto time = std::chrono::system_clock::to_time_t(expense.date);
-        std::tm tm = *std::localtime(&time);
-        char date_str[11];
-        std::strftime(date_str, sizeof(date_str), "%d/%m/%Y", &tm);
-        
-        file << date_str << ","
-             << expense.month << ","
-             << expense.file_origin << ","
-             << expense.description << ","
-             << std::fixed << std::setprecision(2) << std::abs(expense.amount) << ","
-             << currencyToSymbol(expense.currency) << ","
-             << expense.category << "\n";
+    // Write data for each category
+    const size_t columns = table.periods.size();
+    for (size_t row = 0; row < table.categories.size(); ++row) {
+        file << table.categories[row];
+        for (size_t column = 0; column < columns; ++column) {
+            file << "," << table.totals[row * columns + column].toString();
+        }
+        file << "\n";
     }
 }
 
-} // namespace finance 
\ No newline at end of file
+} // namespace finance
@@ -2,22 +2,169 @@
 #include "data_loader.hpp"
 #include "csv_parser.hpp"
 #include "transaction_parser.hpp"
+#include "mapped_file.hpp"
+#include "parallel_for.hpp"
+#include "expense_cache.hpp"
+#include "hash_utils.hpp"
+#include "input_manifest.hpp"
+#include "row_decoder.hpp"
 #include <filesystem>   
 #include <fstream>      
 #include <sstream>      
 #include <iostream>    
 #include <algorithm>   
 #include <iomanip>     
-#include <regex>        
 #include <numeric>      
+#include <iterator>
+#include <cstring>
 
 namespace finance {
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Files smaller than two chunks of this size are parsed on a single thread
+constexpr size_t MIN_CHUNK_BYTES = 8 << 20;
+
+// Yields CSV records from a memory mapping. Records end at line feeds outside
+// quotes, so quoted fields may span lines.
+class MappedRecordReader {
+public:
+    explicit MappedRecordReader(std::string_view contents)
+        : contents_(contents) {}
+    
+    bool next(std::string_view& record) {
+        if (position_ >= contents_.size()) {
+            return false;
+        }
+        
+        const char* start = contents_.data() + position_;
+        bool in_quotes = false;
+        size_t length = scanner_.findRecordEnd(start, contents_.size() - position_, in_quotes);
+        
+        record = std::string_view(start, length);
+        position_ += length + 1;
+        return true;
+    }
+    
+    // Offset of the next unread record
+    size_t position() const { return std::min(position_, contents_.size()); }
+
+private:
+    CSVScanner scanner_;
+    std::string_view contents_;
+    size_t position_ = 0;
+};
+
+// Yields CSV records from a stream, joining lines while a quote is open;
+// each view is valid until the next call
+class StreamRecordReader {
+public:
+    explicit StreamRecordReader(std::istream& stream)
+        : stream_(stream) {}
+    
+    bool next(std::string_view& record) {
+        if (!std::getline(stream_, record_)) {
+            return false;
+        }
+        
+        size_t quotes = std::count(record_.begin(), record_.end(), '"');
+        while (quotes % 2 != 0 && std::getline(stream_, continuation_)) {
+            record_ += '\n';
+            record_ += continuation_;
+            quotes += std::count(continuation_.begin(), continuation_.end(), '"');
+        }
+        
+        record = record_;
+        return true;
+    }
+
+private:
+    std::istream& stream_;
+    std::string record_;
+    std::string continuation_;
+};
+
+// Yields the records held in a streaming batch
+class BatchRecordReader {
+public:
+    explicit BatchRecordReader(const DataLoader::RecordBatch& batch)
+        : batch_(batch) {}
+    
+    bool next(std::string_view& record) {
+        if (index_ >= batch_.record_ends.size()) {
+            return false;
+        }
+        size_t begin = index_ == 0 ? 0 : batch_.record_ends[index_ - 1];
+        size_t end = batch_.record_ends[index_++];
+        record = std::string_view(batch_.text.data() + begin, end - begin);
+        return true;
+    }
+
+private:
+    const DataLoader::RecordBatch& batch_;
+    size_t index_ = 0;
+};
+
+// Split contents[begin, end) into at most chunk_count ranges that each start
+// at a record boundary. The quote state at every nominal split point is
+// derived from per-chunk quote counts, then each split is advanced to the
+// next line feed outside quotes.
+std::vector<std::pair<size_t, size_t>> splitIntoRecordRanges(
+    std::string_view contents, size_t begin, size_t chunk_count) {
+    
+    const size_t end = contents.size();
+    chunk_count = std::max<size_t>(1, std::min(chunk_count, (end - begin) / MIN_CHUNK_BYTES));
+    if (chunk_count == 1) {
+        return {{begin, end}};
+    }
+    
+    std::vector<size_t> nominal(chunk_count + 1);
+    for (size_t i = 0; i <= chunk_count; ++i) {
+        nominal[i] = begin + (end - begin) * i / chunk_count;
+    }
+    
+    std::vector<size_t> quote_counts(chunk_count);
+    parallelFor(chunk_count, chunk_count, [&](size_t i) {
+        CSVScanner scanner;
+        quote_counts[i] = scanner.countQuotes(contents.data() + nominal[i],
+                                              nominal[i + 1] - nominal[i]);
+    });
+    
+    CSVScanner scanner;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t range_start = begin;
+    size_t quotes_before = 0;
+    for (size_t i = 1; i < chunk_count; ++i) {
+        quotes_before += quote_counts[i - 1];
+        bool in_quotes = quotes_before % 2 != 0;
+        size_t record_end = nominal[i] + scanner.findRecordEnd(
+            contents.data() + nominal[i], end - nominal[i], in_quotes);
+        size_t split = std::min(record_end + 1, end);
+        
+        // A record longer than a chunk can swallow the next split point
+        if (split > range_start) {
+            ranges.emplace_back(range_start, split);
+            range_start = split;
+        }
+    }
+    if (range_start < end) {
+        ranges.emplace_back(range_start, end);
+    }
+    
+    return ranges;
+}
+
+} // namespace
+
 // Constructor implementation
-DataLoader::DataLoader(const std::string& directory)
+DataLoader::DataLoader(const std::string& directory,
+                       bool use_memory_map,
+                       size_t max_threads)
     : directory_(directory) 
+    , use_memory_map_(use_memory_map)
+    , max_threads_(max_threads)
 {
 }
 
@@ -45,68 +192,70 @@ std::string DataLoader::getFileOrigin(const std::string& basename) {
                          });
 }
 
+SchemaProfile DataLoader::resolveProfile(std::string_view header_line) const {
+    SchemaProfile profile;
+    const SchemaProfile* known = schemas_
+        ? schemas_->find(SchemaRegistry::fingerprint(header_line)) : nullptr;
+    if (known) {
+        // Registered formats are recognised by their exact header
+        profile = *known;
+    } else {
+        // Otherwise guess the columns from the header names; amounts are
+        // taken as-is, since only a registered profile can vouch for a sign
+        profile.cols = CSVParser::parseHeader(header_line);
+    }
+    
+    // Layouts with a compiled decoder skip the generic per-row lookups
+    if (RowDecoder<MonzoFormat>::matches(profile)) {
+        profile.row_format = RowFormat::Monzo;
+    } else if (RowDecoder<AmexFormat>::matches(profile)) {
+        profile.row_format = RowFormat::Amex;
+    } else {
+        profile.row_format = RowFormat::Generic;
+    }
+    return profile;
+}
+
 Expense DataLoader::createExpense(
-    const std::vector<std::string>& fields,
-    const CSVColumns& cols,
-    const std::string& file_origin) {
+    const CSVTokenizer& fields,
+    const SchemaProfile& profile,
+    Symbol file_origin) {
     
+    const CSVColumns& cols = profile.cols;
     if (fields.size() <= static_cast<size_t>(
         std::max({cols.date_col, cols.description_col, cols.amount_col}))) {
         throw std::runtime_error("Invalid number of fields");
     }
     
     Expense expense;
-    expense.date = TransactionParser::parseDate(fields[cols.date_col]);
-    expense.month = TransactionParser::extractMonth(expense.date);
+    expense.date = TransactionParser::parseDate(fields[cols.date_col], profile.date_format);
     expense.file_origin = file_origin;
     
-    // Clean up description field
-    std::string description = fields[cols.description_col];
-    // Remove any remaining quotes
-    description.erase(std::remove(description.begin(), description.end(), '"'), description.end());
-    
-    // Remove everything after and including the first comma
-    size_t comma_pos = description.find(',');
-    if (comma_pos != std::string::npos) {
-        description = description.substr(0, comma_pos);
-    }
-    
-    // Clean up any extra spaces
-    description = std::regex_replace(description, std::regex(R"(\s+)"), " ");
-    description = std::regex_replace(description, std::regex(R"(^\s+|\s+$)"), "");
-    
-    // Extract currency code from description if present
-    std::regex currency_pattern(R"(\b(GBR|GBP|EUR|USD)\b)");
-    std::smatch match;
-    if (std::regex_search(description, match, currency_pattern)) {
-        expense.currency = stringToCurrency(match[1].str());
-        // Remove the currency code from description
-        description = std::regex_replace(description, currency_pattern, "");
-        // Clean up any extra spaces again
-        description = std::regex_replace(description, std::regex(R"(\s+)"), " ");
-        description = std::regex_replace(description, std::regex(R"(^\s+|\s+$)"), "");
-    }
-    expense.description = description;
+    // Normalise the description in one pass, picking up any currency code
+    expense.currency = TransactionParser::normaliseDescription(
+        fields[cols.description_col], expense.description);
     
     // Parse amount and currency together
     auto [amount, detected_currency] = TransactionParser::parseAmount(fields[cols.amount_col]);
-    expense.amount = amount;
-    // Only use detected currency if we didn't find one in the description
-    if (expense.currency == Currency::UNKNOWN) {
-        expense.currency = detected_currency;
-    }
+    expense.amount = profile.sign == SignConvention::Negate ? -amount : amount;
     
-    // Handle AMEX amount sign
-    bool is_amex = file_origin.find("amex") != std::string::npos || 
-                   file_origin.find("american express") != std::string::npos;
-    if (is_amex) {
-        expense.amount = -expense.amount;
+    // A recognised currency column wins; otherwise use the currency detected
+    // in the amount if none was found in the description
+    Currency column_currency = Currency::UNKNOWN;
+    if (profile.currency_col != -1 &&
+        fields.size() > static_cast<size_t>(profile.currency_col)) {
+        column_currency = stringToCurrency(fields[profile.currency_col]);
+    }
+    if (column_currency != Currency::UNKNOWN) {
+        expense.currency = column_currency;
+    } else if (expense.currency == Currency::UNKNOWN) {
+        expense.currency = detected_currency;
     }
     
     // Handle optional name field
     if (cols.name_col != -1 && 
         fields.size() > static_cast<size_t>(cols.name_col)) {
-        expense.name = fields[cols.name_col];
+        expense.name = Symbol::intern(fields[cols.name_col]);
         
         // Use name as description if description is empty
         if (expense.description.empty()) {
@@ -117,42 +266,65 @@ Expense DataLoader::createExpense(
     return expense;
 }
 
-std::vector<Expense> DataLoader::processFile(const std::string& filepath) {
-    std::vector<Expense> expenses;
-    std::ifstream file(filepath);
+void DataLoader::setCacheDirectory(const std::string& cache_directory) {
+    cache_directory_ = cache_directory;
+}
+
+void DataLoader::setSchemaRegistry(std::shared_ptr<const SchemaRegistry> schemas) {
+    schemas_ = std::move(schemas);
+}
+
+std::string DataLoader::cachePathFor(const std::string& filepath) const {
+    return (fs::path(cache_directory_) /
+            (toHex(fnv1a64(filepath)) + ExpenseCache::FILE_EXTENSION)).string();
+}
+
+std::vector<Expense> DataLoader::processFile(const std::string& filepath, size_t thread_count) {
+    if (cache_directory_.empty()) {
+        return parseFile(filepath, thread_count);
+    }
     
-    if (!file.is_open()) {
-        std::cerr << "Could not open file: " << filepath << std::endl;
+    std::string cache_path = cachePathFor(filepath);
+    std::vector<Expense> expenses;
+    uint64_t parser_hash = schemas_ ? schemas_->contentHash() : 0;
+    if (ExpenseCache::load(cache_path, filepath, parser_hash, expenses)) {
         return expenses;
     }
     
+    // Fingerprint before parsing so a file modified mid-parse reads as stale
+    FileFingerprint source = InputManifest::fingerprint(filepath);
+    expenses = parseFile(filepath, thread_count);
     try {
-        // Read and parse header
-        std::string header_line;
-        if (!std::getline(file, header_line)) {
-            std::cerr << "Empty file: " << filepath << std::endl;
-            return expenses;
+        ExpenseCache::save(cache_path, source, parser_hash, expenses);
+    } catch (const std::exception& e) {
+        std::cerr << "Could not cache " << filepath << ": " << e.what() << std::endl;
+    }
+    return expenses;
+}
+
+std::vector<Expense> DataLoader::parseFile(const std::string& filepath, size_t thread_count) {
+    std::vector<Expense> expenses;
+    
+    try {
+        // Parse directly out of a read-only mapping when the file allows it
+        if (use_memory_map_) {
+            MappedFile mapping;
+            if (mapping.open(filepath)) {
+                return processMappedFile(mapping.view(), filepath, thread_count);
+            }
         }
         
-        CSVColumns cols = CSVParser::parseHeader(header_line);
-        if (cols.date_col == -1 || cols.description_col == -1 || 
-            cols.amount_col == -1) {
-            std::cerr << "Required columns not found in file: " << filepath << std::endl;
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            std::cerr << "Could not open file: " << filepath << std::endl;
             return expenses;
         }
         
+        StreamRecordReader reader(file);
         std::string file_origin = getFileOrigin(fs::path(filepath).filename().string());
-        
-        // Process each line
-        std::string line;
-        while (std::getline(file, line)) {
-            try {
-                auto fields = CSVParser::parseLine(line);
-                expenses.push_back(createExpense(fields, cols, file_origin));
-            } catch (const std::exception& e) {
-                std::cerr << "Error processing line in " << filepath 
-                         << ": " << e.what() << std::endl;
-            }
+        SchemaProfile profile;
+        if (readHeader(reader, filepath, profile)) {
+            parseRows(reader, profile, file_origin, filepath, expenses);
         }
     } catch (const std::exception& e) {
         std::cerr << "Error processing file " << filepath 
@@ -162,19 +334,158 @@ std::vector<Expense> DataLoader::processFile(const std::string& filepath) {
     return expenses;
 }
 
+std::vector<Expense> DataLoader::processMappedFile(std::string_view contents,
+                                                   const std::string& filepath,
+                                                   size_t thread_count) {
+    MappedRecordReader header_reader(contents);
+    std::string file_origin = getFileOrigin(fs::path(filepath).filename().string());
+    SchemaProfile profile;
+    if (!readHeader(header_reader, filepath, profile)) {
+        return std::vector<Expense>();
+    }
+    
+    auto ranges = splitIntoRecordRanges(contents, header_reader.position(), thread_count);
+    
+    // Parse each record-aligned chunk independently
+    std::vector<std::vector<Expense>> chunk_expenses(ranges.size());
+    parallelFor(ranges.size(), thread_count, [&](size_t i) {
+        MappedRecordReader reader(contents.substr(ranges[i].first,
+                                                  ranges[i].second - ranges[i].first));
+        parseRows(reader, profile, file_origin, filepath, chunk_expenses[i]);
+    });
+    
+    if (chunk_expenses.size() == 1) {
+        return std::move(chunk_expenses.front());
+    }
+    
+    // Stitch the chunks back together in file order
+    size_t total = 0;
+    for (const auto& expenses : chunk_expenses) {
+        total += expenses.size();
+    }
+    std::vector<Expense> expenses;
+    expenses.reserve(total);
+    for (auto& chunk : chunk_expenses) {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(expenses));
+    }
+    return expenses;
+}
+
+template <typename RecordReader>
+bool DataLoader::readHeader(RecordReader& reader, const std::string& filepath,
+                            SchemaProfile& profile) {
+    // Read and parse header
+    std::string_view header_line;
+    if (!reader.next(header_line)) {
+        std::cerr << "Empty file: " << filepath << std::endl;
+        return false;
+    }
+    
+    profile = resolveProfile(header_line);
+    const CSVColumns& cols = profile.cols;
+    if (cols.date_col == -1 || cols.description_col == -1 || 
+        cols.amount_col == -1) {
+        std::cerr << "Required columns not found in file: " << filepath << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+template <typename RecordReader>
+void DataLoader::parseRows(RecordReader& reader,
+                           const SchemaProfile& profile,
+                           const std::string& file_origin,
+                           const std::string& filepath,
+                           std::vector<Expense>& expenses) {
+    // Intern the origin once; every row shares it
+    const Symbol origin = Symbol::intern(file_origin);
+    
+    // Pick the row decoder once per file
+    switch (profile.row_format) {
+        case RowFormat::Monzo:
+            decodeRows(reader, RowDecoder<MonzoFormat>::FIELD_LIMIT, filepath, expenses,
+                       [&](const CSVTokenizer& fields) {
+                           return RowDecoder<MonzoFormat>::decode(fields, origin);
+                       });
+            break;
+        case RowFormat::Amex:
+            decodeRows(reader, RowDecoder<AmexFormat>::FIELD_LIMIT, filepath, expenses,
+                       [&](const CSVTokenizer& fields) {
+                           return RowDecoder<AmexFormat>::decode(fields, origin);
+                       });
+            break;
+        default:
+            decodeRows(reader, SIZE_MAX, filepath, expenses,
+                       [&](const CSVTokenizer& fields) {
+                           return createExpense(fields, profile, origin);
+                       });
+            break;
+    }
+}
+
+template <typename RecordReader, typename Decode>
+void DataLoader::decodeRows(RecordReader& reader,
+                            size_t field_limit,
+                            const std::string& filepath,
+                            std::vector<Expense>& expenses,
+                            Decode decode) {
+    // Process each record, reusing the tokenizer's buffers across rows
+    CSVTokenizer fields;
+    std::string_view line;
+    while (reader.next(line)) {
+        try {
+            fields.tokenize(line, field_limit);
+            expenses.push_back(decode(fields));
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing line in " << filepath 
+                     << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+std::vector<std::string> DataLoader::listInputFiles() const {
+    std::vector<std::string> filepaths;
+    for (const auto& entry : fs::directory_iterator(directory_)) {
+        if (entry.path().extension() != ".csv") continue;
+        filepaths.push_back(entry.path().string());
+    }
+    std::sort(filepaths.begin(), filepaths.end());
+    return filepaths;
+}
+
+std::vector<std::vector<Expense>> DataLoader::loadFiles(
+    const std::vector<std::string>& filepaths) {
+    // Parse files concurrently, each into its own slot. The thread budget is
+    // shared: every file worker may split its file over an equal part of it,
+    // so large files are chunked only when few files are loading at once.
+    const size_t budget = max_threads_ == 0 ? defaultThreadCount() : max_threads_;
+    const size_t file_workers = std::max<size_t>(1, std::min(filepaths.size(), budget));
+    const size_t threads_per_file = std::max<size_t>(1, budget / file_workers);
+    
+    std::vector<std::vector<Expense>> file_expenses(filepaths.size());
+    parallelFor(filepaths.size(), file_workers, [&](size_t i) {
+        file_expenses[i] = processFile(filepaths[i], threads_per_file);
+    });
+    return file_expenses;
+}
+
 // Main function to load and process all expense data
 std::vector<Expense> DataLoader::loadAndPreprocessData() {
     std::vector<Expense> all_expenses;
     
     try {
-        // Process each CSV file in the directory
-        for (const auto& entry : fs::directory_iterator(directory_)) {
-            if (entry.path().extension() != ".csv") continue;
-            
-            auto file_expenses = processFile(entry.path().string());
-            all_expenses.insert(all_expenses.end(), 
-                              file_expenses.begin(), 
-                              file_expenses.end());
+        // Files are taken in name order so the output order is deterministic
+        auto file_expenses = loadFiles(listInputFiles());
+        
+        // Merge in file order, moving rows into one pre-sized result
+        size_t total = 0;
+        for (const auto& expenses : file_expenses) {
+            total += expenses.size();
+        }
+        all_expenses.reserve(total);
+        for (auto& expenses : file_expenses) {
+            std::move(expenses.begin(), expenses.end(), std::back_inserter(all_expenses));
         }
     } catch (const std::exception& e) {
         std::cerr << "Error loading data: " << e.what() << std::endl;
@@ -188,4 +499,71 @@ std::vector<Expense> DataLoader::loadAndPreprocessData() {
     return all_expenses;
 }
 
-} // namespace finance 
\ No newline at end of file
+void DataLoader::readRecordBatches(size_t batch_size,
+                                   const std::function<bool(RecordBatch&&)>& sink) {
+    try {
+        for (const auto& filepath : listInputFiles()) {
+            if (use_memory_map_) {
+                MappedFile mapping;
+                if (mapping.open(filepath)) {
+                    MappedRecordReader reader(mapping.view());
+                    if (!readFileBatches(reader, filepath, batch_size, sink)) return;
+                    continue;
+                }
+            }
+            
+            std::ifstream file(filepath);
+            if (!file.is_open()) {
+                std::cerr << "Could not open file: " << filepath << std::endl;
+                continue;
+            }
+            StreamRecordReader reader(file);
+            if (!readFileBatches(reader, filepath, batch_size, sink)) return;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading data: " << e.what() << std::endl;
+    }
+}
+
+template <typename RecordReader>
+bool DataLoader::readFileBatches(RecordReader& reader,
+                                 const std::string& filepath,
+                                 size_t batch_size,
+                                 const std::function<bool(RecordBatch&&)>& sink) {
+    auto file = std::make_shared<InputFile>();
+    file->filepath = filepath;
+    file->file_origin = getFileOrigin(fs::path(filepath).filename().string());
+    if (!readHeader(reader, filepath, file->profile)) {
+        return true;
+    }
+    
+    RecordBatch batch;
+    batch.file = file;
+    std::string_view record;
+    while (reader.next(record)) {
+        batch.text.append(record);
+        batch.record_ends.push_back(batch.text.size());
+        
+        if (batch.record_ends.size() >= batch_size) {
+            if (!sink(std::move(batch))) {
+                return false;
+            }
+            batch = RecordBatch();
+            batch.file = file;
+        }
+    }
+    
+    return batch.record_ends.empty() || sink(std::move(batch));
+}
+
+std::vector<Expense> DataLoader::parseRecordBatch(const RecordBatch& batch) {
+    std::vector<Expense> expenses;
+    expenses.reserve(batch.record_ends.size());
+    
+    BatchRecordReader reader(batch);
+    parseRows(reader, batch.file->profile, batch.file->file_origin,
+              batch.file->filepath, expenses);
+    return expenses;
+}
+
+} // namespace finance
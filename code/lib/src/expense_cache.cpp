@@ -0,0 +1,301 @@
+#include "expense_cache.hpp"
+#include "hash_utils.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'F', 'I', 'N', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t CACHE_VERSION = 4;
+
+enum Section : size_t {
+    DATES,            // int32 civil day numbers
+    AMOUNTS,          // int64 minor units
+    CURRENCIES,       // uint8 Currency values
+    ORIGIN_IDS,       // uint32 ids into ORIGIN_DICT, and so on
+    DESCRIPTION_IDS,
+    NAME_IDS,
+    ORIGIN_DICT,      // uint32 count, uint32 offsets[count + 1], bytes
+    DESCRIPTION_DICT,
+    NAME_DICT,
+    SECTION_COUNT
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t minor_per_major;   // Money::MINOR_PER_MAJOR when written
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint64_t parser_hash;       // Parsing configuration the rows came from
+    uint64_t row_count;
+    uint64_t file_size;
+    uint64_t checksum;          // FNV-1a of everything after the header
+    uint64_t section_offsets[SECTION_COUNT];
+};
+
+// Dictionary encoder for one string column, keyed by symbol id
+class Dictionary {
+public:
+    uint32_t idOf(Symbol value) {
+        auto [it, inserted] = ids_.emplace(value.id(), static_cast<uint32_t>(values_.size()));
+        if (inserted) {
+            values_.push_back(value);
+        }
+        return it->second;
+    }
+    
+    void write(std::string& out) const {
+        uint32_t count = static_cast<uint32_t>(values_.size());
+        out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        uint32_t offset = 0;
+        out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        for (Symbol value : values_) {
+            offset += static_cast<uint32_t>(value.size());
+            out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        }
+        for (Symbol value : values_) {
+            out.append(value.view().data(), value.size());
+        }
+    }
+
+private:
+    std::unordered_map<uint32_t, uint32_t> ids_;
+    std::vector<Symbol> values_;
+};
+
+void alignTo8(std::string& out) {
+    out.resize((out.size() + 7) & ~size_t{7}, '\0');
+}
+
+template <typename T>
+void appendColumn(std::string& out, const std::vector<T>& values) {
+    out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+// Validated, read-only view over a mapped cache file
+class CacheView {
+public:
+    explicit CacheView(const MappedFile& mapping)
+        : data_(mapping.data()), size_(mapping.size()) {}
+    
+    const CacheHeader* header() const {
+        if (size_ < sizeof(CacheHeader)) return nullptr;
+        auto header = reinterpret_cast<const CacheHeader*>(data_);
+        if (std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+            header->version != CACHE_VERSION ||
+            header->file_size != size_) {
+            return nullptr;
+        }
+        return header;
+    }
+    
+    // Column of row_count values of T, or nullptr if out of bounds
+    template <typename T>
+    const T* column(const CacheHeader& header, Section section) const {
+        uint64_t offset = header.section_offsets[section];
+        if (offset % alignof(T) != 0 || offset > size_ ||
+            header.row_count > (size_ - offset) / sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+    
+    // Decode a dictionary section into views over the mapping
+    bool dictionary(const CacheHeader& header, Section section,
+                    std::vector<std::string_view>& values) const {
+        uint64_t offset = header.section_offsets[section];
+        if (offset % alignof(uint32_t) != 0 || offset > size_ || size_ - offset < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t count;
+        std::memcpy(&count, data_ + offset, sizeof(count));
+        const uint64_t offsets_end = offset + sizeof(uint32_t) * (uint64_t{count} + 2);
+        if (offsets_end > size_) {
+            return false;
+        }
+        
+        auto offsets = reinterpret_cast<const uint32_t*>(data_ + offset + sizeof(uint32_t));
+        const char* bytes = data_ + offsets_end;
+        const uint64_t bytes_size = size_ - offsets_end;
+        values.clear();
+        values.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > bytes_size) {
+                return false;
+            }
+            values.emplace_back(bytes + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        return true;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+bool matchesSource(const CacheHeader& header, const std::string& source_path) {
+    FileFingerprint stored;
+    stored.size = header.source_size;
+    stored.mtime = header.source_mtime;
+    stored.content_hash = header.source_hash;
+    
+    std::error_code error;
+    if (!fs::is_regular_file(source_path, error)) {
+        return false;
+    }
+    
+    // Size and mtime unchanged: trusted without re-reading the source
+    FileFingerprint current = InputManifest::fingerprint(source_path, &stored);
+    return current.size == stored.size && current.content_hash == stored.content_hash;
+}
+
+} // namespace
+
+void ExpenseCache::save(const std::string& cache_path,
+                        const FileFingerprint& source,
+                        uint64_t parser_hash,
+                        const std::vector<Expense>& expenses) {
+    const size_t rows = expenses.size();
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.minor_per_major = static_cast<uint32_t>(Money::MINOR_PER_MAJOR);
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.source_hash = source.content_hash;
+    header.parser_hash = parser_hash;
+    header.row_count = rows;
+    
+    // Build the columns
+    std::vector<int32_t> dates(rows);
+    std::vector<int64_t> amounts(rows);
+    std::vector<uint8_t> currencies(rows);
+    std::vector<uint32_t> origin_ids(rows), description_ids(rows), name_ids(rows);
+    Dictionary origins, descriptions, names;
+    
+    for (size_t i = 0; i < rows; ++i) {
+        const Expense& expense = expenses[i];
+        dates[i] = expense.date.dayNumber();
+        amounts[i] = expense.amount.minorUnits();
+        currencies[i] = static_cast<uint8_t>(expense.currency);
+        origin_ids[i] = origins.idOf(expense.file_origin);
+        description_ids[i] = descriptions.idOf(expense.description);
+        name_ids[i] = names.idOf(expense.name);
+    }
+    
+    // Lay out 8-byte aligned sections after the header
+    std::string out(sizeof(CacheHeader), '\0');
+    auto beginSection = [&](Section section) {
+        alignTo8(out);
+        header.section_offsets[section] = out.size();
+    };
+    beginSection(DATES);           appendColumn(out, dates);
+    beginSection(AMOUNTS);         appendColumn(out, amounts);
+    beginSection(CURRENCIES);      appendColumn(out, currencies);
+    beginSection(ORIGIN_IDS);      appendColumn(out, origin_ids);
+    beginSection(DESCRIPTION_IDS); appendColumn(out, description_ids);
+    beginSection(NAME_IDS);        appendColumn(out, name_ids);
+    beginSection(ORIGIN_DICT);      origins.write(out);
+    beginSection(DESCRIPTION_DICT); descriptions.write(out);
+    beginSection(NAME_DICT);        names.write(out);
+    alignTo8(out);
+    
+    header.file_size = out.size();
+    header.checksum = fnv1a64(std::string_view(out).substr(sizeof(CacheHeader)));
+    std::memcpy(&out[0], &header, sizeof(header));
+    
+    // Write to a temporary file first so a crash never leaves a torn cache
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    fs::rename(temp_path, cache_path);
+}
+
+bool ExpenseCache::load(const std::string& cache_path,
+                        const std::string& source_path,
+                        uint64_t parser_hash,
+                        std::vector<Expense>& expenses) {
+    MappedFile mapping;
+    if (!mapping.open(cache_path)) {
+        return false;
+    }
+    
+    CacheView view(mapping);
+    const CacheHeader* header = view.header();
+    if (!header || header->parser_hash != parser_hash ||
+        !matchesSource(*header, source_path)) {
+        return false;
+    }
+    if (fnv1a64(mapping.view().substr(sizeof(CacheHeader))) != header->checksum) {
+        return false;
+    }
+    
+    auto dates = view.column<int32_t>(*header, DATES);
+    auto amounts = view.column<int64_t>(*header, AMOUNTS);
+    auto currencies = view.column<uint8_t>(*header, CURRENCIES);
+    auto origin_ids = view.column<uint32_t>(*header, ORIGIN_IDS);
+    auto description_ids = view.column<uint32_t>(*header, DESCRIPTION_IDS);
+    auto name_ids = view.column<uint32_t>(*header, NAME_IDS);
+    std::vector<std::string_view> origins, descriptions, names;
+    if (!dates || !amounts || !currencies || !origin_ids ||
+        !description_ids || !name_ids ||
+        !view.dictionary(*header, ORIGIN_DICT, origins) ||
+        !view.dictionary(*header, DESCRIPTION_DICT, descriptions) ||
+        !view.dictionary(*header, NAME_DICT, names)) {
+        return false;
+    }
+    
+    if (header->minor_per_major != Money::MINOR_PER_MAJOR) {
+        return false;
+    }
+    
+    // Intern each distinct string once; rows then share the symbols
+    auto internAll = [](const std::vector<std::string_view>& values) {
+        std::vector<Symbol> symbols;
+        symbols.reserve(values.size());
+        for (std::string_view value : values) {
+            symbols.push_back(Symbol::intern(value));
+        }
+        return symbols;
+    };
+    const std::vector<Symbol> origin_symbols = internAll(origins);
+    const std::vector<Symbol> description_symbols = internAll(descriptions);
+    const std::vector<Symbol> name_symbols = internAll(names);
+    
+    std::vector<Expense> loaded(header->row_count);
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        if (origin_ids[i] >= origins.size() ||
+            description_ids[i] >= descriptions.size() || name_ids[i] >= names.size()) {
+            return false;
+        }
+        
+        Expense& expense = loaded[i];
+        expense.date = CivilDate::fromDayNumber(dates[i]);
+        expense.amount = Money::fromMinor(amounts[i]);
+        expense.currency = static_cast<Currency>(currencies[i]);
+        expense.file_origin = origin_symbols[origin_ids[i]];
+        expense.description = description_symbols[description_ids[i]];
+        expense.name = name_symbols[name_ids[i]];
+    }
+    
+    expenses = std::move(loaded);
+    return true;
+}
+
+} // namespace finance
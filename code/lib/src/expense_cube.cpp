@@ -0,0 +1,421 @@
+#include "expense_cube.hpp"
+#include "hash_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CUBE_MAGIC[8] = {'F', 'I', 'N', 'C', 'U', 'B', 'E', '1'};
+constexpr uint32_t CUBE_VERSION = 1;
+
+struct CubeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t category_count;
+    uint64_t origin_count;
+    uint64_t cell_count;
+    uint64_t row_count;
+    uint64_t fingerprint;
+    uint64_t file_size;
+    uint64_t checksum;          // FNV-1a of everything after the header
+};
+
+// Category names, then origin names, follow the header: each a list of
+// uint32 offsets[count + 1] and then bytes, padded to 8 bytes. Then the day
+// cells; month cells are rebuilt from them on load.
+struct CubeCell {
+    uint32_t category;
+    uint32_t origin;
+    int32_t day;
+    uint32_t currency;
+    int64_t sum;                // Pence
+    uint64_t count;
+    int64_t min;
+    int64_t max;
+};
+
+void appendNames(std::string& out, const std::vector<Symbol>& symbols) {
+    uint32_t offset = 0;
+    out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    for (Symbol symbol : symbols) {
+        offset += static_cast<uint32_t>(symbol.size());
+        out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    for (Symbol symbol : symbols) {
+        out.append(symbol.view().data(), symbol.size());
+    }
+    out.resize((out.size() + 7) & ~size_t{7}, '\0');
+}
+
+// Read count names written by appendNames at position, moving past them
+bool readNames(const std::string& bytes, size_t& position, uint64_t count,
+               std::vector<Symbol>& symbols) {
+    if (count >= UINT32_MAX || position > bytes.size() ||
+        sizeof(uint32_t) * (count + 1) > bytes.size() - position) {
+        return false;
+    }
+    const size_t names_begin = position + sizeof(uint32_t) * (count + 1);
+    uint32_t begin = 0;
+    std::memcpy(&begin, bytes.data() + position, sizeof(begin));
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t end;
+        std::memcpy(&end, bytes.data() + position + sizeof(uint32_t) * (i + 1), sizeof(end));
+        if (begin > end || end > bytes.size() - names_begin) {
+            return false;
+        }
+        symbols.push_back(Symbol::intern(std::string_view(bytes.data() + names_begin + begin, end - begin)));
+        begin = end;
+    }
+    if (begin > bytes.size() - names_begin) {
+        return false;
+    }
+    position = (names_begin + begin + 7) & ~size_t{7};
+    return true;
+}
+
+// Currency enum values are 0 .. CURRENCY_COUNT - 1
+constexpr size_t CURRENCY_COUNT = static_cast<size_t>(Currency::UNKNOWN) + 1;
+
+// Largest grouping rolled up through a dense array; bigger ones use a map
+constexpr uint64_t DENSE_GROUP_LIMIT = uint64_t{1} << 22;
+
+} // namespace
+
+void ExpenseCube::Measures::add(Money amount) {
+    if (count == 0 || amount < min) min = amount;
+    if (count == 0 || max < amount) max = amount;
+    sum += amount;
+    ++count;
+}
+
+void ExpenseCube::Measures::merge(const Measures& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0 || other.min < min) min = other.min;
+    if (count == 0 || max < other.max) max = other.max;
+    sum += other.sum;
+    count += other.count;
+}
+
+size_t ExpenseCube::hashKey(const Key& key) {
+    uint64_t hash = (uint64_t{key.category} << 32) ^ static_cast<uint32_t>(key.period);
+    hash ^= ((uint64_t{key.origin} << 8) | static_cast<uint64_t>(key.currency)) * 0x9e3779b97f4a7c15ULL;
+    // splitmix64 finaliser
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(hash ^ (hash >> 31));
+}
+
+void ExpenseCube::Level::rehash(size_t capacity) {
+    table.assign(capacity, 0);
+    const size_t mask = capacity - 1;
+    for (uint32_t cell = 0; cell < cells.size(); ++cell) {
+        size_t pos = hashKey(cells[cell].key) & mask;
+        while (table[pos] != 0) {
+            pos = (pos + 1) & mask;
+        }
+        table[pos] = cell + 1;
+    }
+}
+
+ExpenseCube::Measures& ExpenseCube::Level::at(const Key& key) {
+    // Keep the table at most half full so probes stay short
+    if ((cells.size() + 1) * 2 > table.size()) {
+        rehash(std::max<size_t>(1024, table.size() * 2));
+    }
+
+    const size_t mask = table.size() - 1;
+    size_t pos = hashKey(key) & mask;
+    while (table[pos] != 0) {
+        Entry& cell = cells[table[pos] - 1];
+        if (cell.key == key) {
+            return cell.measures;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    if (cells.size() >= UINT32_MAX - 1) {
+        throw std::runtime_error("Too many expense cube cells");
+    }
+    cells.push_back(Entry{key, Measures()});
+    table[pos] = static_cast<uint32_t>(cells.size());
+    first_period = std::min(first_period, key.period);
+    last_period = std::max(last_period, key.period);
+    return cells.back().measures;
+}
+
+uint32_t ExpenseCube::slotOf(Symbol symbol, std::vector<Symbol>& symbols,
+                             std::unordered_map<uint32_t, uint32_t>& slots) {
+    auto [slot, inserted] = slots.try_emplace(symbol.id(), static_cast<uint32_t>(symbols.size()));
+    if (inserted) {
+        symbols.push_back(symbol);
+    }
+    return slot->second;
+}
+
+void ExpenseCube::add(const std::vector<Expense>& expenses, Symbol uncategorised) {
+    for (const auto& expense : expenses) {
+        add(expense, expense.category.empty() ? uncategorised : expense.category);
+    }
+}
+
+void ExpenseCube::add(const Expense& expense, Symbol category) {
+    Key key{slotOf(category, categories_, category_slots_),
+            slotOf(expense.file_origin, origins_, origin_slots_),
+            expense.date.dayNumber(),
+            expense.currency};
+    Money amount = toGbp(expense.amount, expense.currency);
+    days_.at(key).add(amount);
+    key.period = expense.date.monthKey();
+    months_.at(key).add(amount);
+    ++row_count_;
+}
+
+bool ExpenseCube::monthAligned(unsigned group_by, const Granularity& granularity,
+                               const Slice& slice) {
+    if (group_by & PERIOD) {
+        using Unit = Granularity::Unit;
+        bool whole_months = granularity.unit == Unit::Month ||
+                            granularity.unit == Unit::Quarter ||
+                            granularity.unit == Unit::Year ||
+                            (granularity.unit == Unit::FiscalYear && granularity.start_day == 1);
+        if (!whole_months) {
+            return false;
+        }
+    }
+
+    int year = 0;
+    unsigned month = 0, day = 0;
+    if (slice.first.dayNumber() != INT32_MIN) {
+        slice.first.toYmd(year, month, day);
+        if (day != 1) return false;
+    }
+    if (slice.last.dayNumber() != INT32_MAX) {
+        CivilDate::fromDayNumber(slice.last.dayNumber() + 1).toYmd(year, month, day);
+        if (day != 1) return false;
+    }
+    return true;
+}
+
+std::vector<ExpenseCube::Cell> ExpenseCube::query(unsigned group_by,
+                                                  const Granularity& granularity,
+                                                  const Slice& slice) const {
+    const bool by_month = monthAligned(group_by, granularity, slice);
+    const Level& level = by_month ? months_ : days_;
+    std::vector<Cell> result;
+    if (level.cells.empty()) {
+        return result;
+    }
+
+    // Slice the periods in the level's units
+    int32_t first = level.first_period;
+    int32_t last = level.last_period;
+    if (slice.first.dayNumber() != INT32_MIN) {
+        first = std::max(first, by_month ? slice.first.monthKey() : slice.first.dayNumber());
+    }
+    if (slice.last.dayNumber() != INT32_MAX) {
+        last = std::min(last, by_month ? slice.last.monthKey() : slice.last.dayNumber());
+    }
+    if (first > last) {
+        return result;
+    }
+
+    // Which slots the slice lets through
+    auto allowed = [](const std::vector<Symbol>& wanted, const std::vector<Symbol>& symbols) {
+        std::vector<char> allowed(symbols.size(), wanted.empty());
+        for (size_t slot = 0; slot < symbols.size(); ++slot) {
+            if (std::find(wanted.begin(), wanted.end(), symbols[slot]) != wanted.end()) {
+                allowed[slot] = true;
+            }
+        }
+        return allowed;
+    };
+    const std::vector<char> categories = allowed(slice.categories, categories_);
+    const std::vector<char> origins = allowed(slice.origins, origins_);
+    char currencies[CURRENCY_COUNT];
+    for (size_t currency = 0; currency < CURRENCY_COUNT; ++currency) {
+        currencies[currency] = slice.currencies.empty() ||
+            std::find(slice.currencies.begin(), slice.currencies.end(),
+                      static_cast<Currency>(currency)) != slice.currencies.end();
+    }
+
+    // Output period of each level period, as an offset from the first
+    auto dateOf = [by_month](int32_t period) {
+        return by_month ? CivilDate::fromYmd(period / 12, static_cast<unsigned>(period % 12) + 1, 1)
+                        : CivilDate::fromDayNumber(period);
+    };
+    std::vector<uint32_t> period_offsets;
+    int32_t first_key = 0;
+    if (group_by & PERIOD) {
+        first_key = granularity.key(dateOf(first));
+        period_offsets.resize(static_cast<size_t>(last - first) + 1);
+        for (int32_t period = first; period <= last; ++period) {
+            period_offsets[static_cast<size_t>(period - first)] =
+                static_cast<uint32_t>(granularity.key(dateOf(period)) - first_key);
+        }
+    }
+
+    // Groups are numbered densely by the grouped dimensions
+    const uint64_t category_count = (group_by & CATEGORY) ? categories_.size() : 1;
+    const uint64_t period_count = (group_by & PERIOD) ? uint64_t{period_offsets.back()} + 1 : 1;
+    const uint64_t origin_count = (group_by & ORIGIN) ? origins_.size() : 1;
+    const uint64_t currency_count = (group_by & CURRENCY) ? CURRENCY_COUNT : 1;
+    const uint64_t group_count = category_count * period_count * origin_count * currency_count;
+    const bool dense = group_count <= DENSE_GROUP_LIMIT;
+    std::vector<uint32_t> dense_groups(dense ? group_count : 0, 0);   // Result index + 1
+    std::unordered_map<uint64_t, uint32_t> sparse_groups;
+
+    for (const auto& cell : level.cells) {
+        const Key& key = cell.key;
+        if (key.period < first || key.period > last || !categories[key.category] ||
+            !origins[key.origin] || !currencies[static_cast<size_t>(key.currency)]) {
+            continue;
+        }
+
+        const uint64_t category = (group_by & CATEGORY) ? key.category : 0;
+        const uint64_t period = (group_by & PERIOD) ? period_offsets[static_cast<size_t>(key.period - first)] : 0;
+        const uint64_t origin = (group_by & ORIGIN) ? key.origin : 0;
+        const uint64_t currency = (group_by & CURRENCY) ? static_cast<uint64_t>(key.currency) : 0;
+        const uint64_t group = ((category * period_count + period) * origin_count + origin) * currency_count + currency;
+
+        uint32_t& index = dense ? dense_groups[group] : sparse_groups[group];
+        if (index == 0) {
+            Cell out;
+            if (group_by & CATEGORY) out.category = categories_[key.category];
+            if (group_by & PERIOD) out.period = first_key + static_cast<int32_t>(period);
+            if (group_by & ORIGIN) out.origin = origins_[key.origin];
+            if (group_by & CURRENCY) out.currency = key.currency;
+            result.push_back(out);
+            index = static_cast<uint32_t>(result.size());
+        }
+        result[index - 1].measures.merge(cell.measures);
+    }
+
+    std::sort(result.begin(), result.end(), [](const Cell& a, const Cell& b) {
+        return std::make_tuple(a.category.view(), a.period, a.origin.view(), a.currency) <
+               std::make_tuple(b.category.view(), b.period, b.origin.view(), b.currency);
+    });
+    return result;
+}
+
+ExpenseCube::Measures ExpenseCube::total(const Slice& slice) const {
+    auto cells = query(0, Granularity::month(), slice);
+    return cells.empty() ? Measures() : cells.front().measures;
+}
+
+void ExpenseCube::save(const std::string& filepath, uint64_t fingerprint) const {
+    CubeHeader header = {};
+    std::memcpy(header.magic, CUBE_MAGIC, sizeof(CUBE_MAGIC));
+    header.version = CUBE_VERSION;
+    header.category_count = categories_.size();
+    header.origin_count = origins_.size();
+    header.cell_count = days_.cells.size();
+    header.row_count = row_count_;
+    header.fingerprint = fingerprint;
+    
+    std::string out(sizeof(header), '\0');
+    appendNames(out, categories_);
+    appendNames(out, origins_);
+    out.reserve(out.size() + sizeof(CubeCell) * days_.cells.size());
+    for (const auto& cell : days_.cells) {
+        CubeCell record = {cell.key.category, cell.key.origin, cell.key.period,
+                           static_cast<uint32_t>(cell.key.currency),
+                           cell.measures.sum.minorUnits(), cell.measures.count,
+                           cell.measures.min.minorUnits(), cell.measures.max.minorUnits()};
+        out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    header.file_size = out.size();
+    header.checksum = fnv1a64(std::string_view(out).substr(sizeof(header)));
+    std::memcpy(&out[0], &header, sizeof(header));
+    
+    // Write to a temporary file first so a crash never leaves a torn cube
+    std::string temp_path = filepath + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    fs::rename(temp_path, filepath);
+}
+
+bool ExpenseCube::load(const std::string& filepath, uint64_t fingerprint) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    CubeHeader header;
+    if (bytes.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, CUBE_MAGIC, sizeof(CUBE_MAGIC)) != 0 ||
+        header.version != CUBE_VERSION ||
+        header.fingerprint != fingerprint ||
+        header.file_size != bytes.size() ||
+        fnv1a64(std::string_view(bytes).substr(sizeof(header))) != header.checksum) {
+        return false;
+    }
+    
+    ExpenseCube cube;
+    size_t position = sizeof(header);
+    if (!readNames(bytes, position, header.category_count, cube.categories_) ||
+        !readNames(bytes, position, header.origin_count, cube.origins_)) {
+        return false;
+    }
+    for (uint32_t slot = 0; slot < cube.categories_.size(); ++slot) {
+        if (!cube.category_slots_.emplace(cube.categories_[slot].id(), slot).second) {
+            return false;
+        }
+    }
+    for (uint32_t slot = 0; slot < cube.origins_.size(); ++slot) {
+        if (!cube.origin_slots_.emplace(cube.origins_[slot].id(), slot).second) {
+            return false;
+        }
+    }
+    
+    if (position > bytes.size() || header.cell_count != (bytes.size() - position) / sizeof(CubeCell) ||
+        (bytes.size() - position) % sizeof(CubeCell) != 0) {
+        return false;
+    }
+    for (size_t cell = 0; cell < header.cell_count; ++cell) {
+        CubeCell record;
+        std::memcpy(&record, bytes.data() + position + sizeof(record) * cell, sizeof(record));
+        if (record.category >= cube.categories_.size() ||
+            record.origin >= cube.origins_.size() ||
+            record.currency >= CURRENCY_COUNT ||
+            record.count == 0) {
+            return false;
+        }
+        
+        Measures measures;
+        measures.sum = Money::fromMinor(record.sum);
+        measures.count = static_cast<size_t>(record.count);
+        measures.min = Money::fromMinor(record.min);
+        measures.max = Money::fromMinor(record.max);
+        Key key{record.category, record.origin, record.day, static_cast<Currency>(record.currency)};
+        cube.days_.at(key).merge(measures);
+        key.period = CivilDate::fromDayNumber(record.day).monthKey();
+        cube.months_.at(key).merge(measures);
+    }
+    cube.row_count_ = static_cast<size_t>(header.row_count);
+    
+    *this = std::move(cube);
+    return true;
+}
+
+} // namespace finance
@@ -5,11 +5,29 @@
 #include "transaction_categorisation.hpp"
 #include "report_generator.hpp"
 #include "data_exporter.hpp"
+#include "bounded_queue.hpp"
+#include "hash_utils.hpp"
+#include <exception>
 #include <iostream>
 #include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+// Manifest and per-file parse caches live here, inside the output directory
+static const char* CACHE_DIRECTORY = ".finance_cache";
+static const char* MANIFEST_FILE = "manifest.csv";
+static const char* CATEGORY_MEMO_FILE = "category_memo.bin";
+static const char* RULE_PACK_FILE = "keyword_rules.pack";
+static const char* SUMMARY_TOTALS_FILE = "summary_totals.bin";
+static const char* EXPENSE_CUBE_FILE = "expense_cube.bin";
+
+// Default schema profiles file, looked for beside the keyword file
+static const char* SCHEMA_FILE = "bank_schemas.csv";
+
 // Function to ensure directory exists
 static void ensureDirectoryExists(const std::string& path) {
     if (!fs::exists(path)) {
@@ -26,47 +44,520 @@ FinanceProcessor::FinanceProcessor(const std::string& directory,
     : directory_(directory)
     , output_dir_(output_dir)
     , keyword_file_(keyword_file)
+    , schema_file_((fs::path(keyword_file).parent_path() / SCHEMA_FILE).string())
     , export_monthly_summary_(export_monthly_summary)
     , export_weekly_summary_(export_weekly_summary)
     , export_full_dataset_(export_full_dataset) {}
 
+void FinanceProcessor::setStreamingMode(bool enabled, size_t batch_size) {
+    streaming_ = enabled;
+    streaming_batch_size_ = batch_size == 0 ? DEFAULT_STREAMING_BATCH_SIZE : batch_size;
+}
+
+void FinanceProcessor::setIncrementalMode(bool enabled) {
+    incremental_ = enabled;
+}
+
+void FinanceProcessor::setThreadCount(size_t thread_count) {
+    thread_count_ = thread_count;
+}
+
+void FinanceProcessor::setKeywordHotReload(bool enabled) {
+    hot_reload_ = enabled;
+    if (!enabled) {
+        category_index_.reset();
+    }
+}
+
+void FinanceProcessor::setCategorisationStats(bool enabled) {
+    categorisation_stats_ = enabled;
+}
+
+void FinanceProcessor::setSchemaFile(const std::string& schema_file) {
+    schema_file_ = schema_file;
+}
+
 void FinanceProcessor::run() {
+    category_index_.reset();
+    cube_.reset();
     try {
         // Ensure directories exist
         ensureDirectoryExists(directory_);
         ensureDirectoryExists(output_dir_);
         
-        // Load keyword mapping
+        // Load keyword mapping, compiled once into a rule pack kept with the
+        // caches and reused until the keyword file changes
+        std::string rule_pack_path;
+        if (incremental_) {
+            fs::path cache_dir = fs::path(output_dir_) / CACHE_DIRECTORY;
+            ensureDirectoryExists(cache_dir.string());
+            rule_pack_path = (cache_dir / RULE_PACK_FILE).string();
+        }
         finance::KeywordLoader loader(keyword_file_);
-        auto keyword_map = loader.loadKeywords();
-        if (keyword_map.empty()) {
+        auto rules = loader.loadRulePack(rule_pack_path);
+        if (rules->keywordCount() == 0) {
             throw std::runtime_error("Failed to load keyword mapping");
         }
         
+        // Load bank format profiles, if any
+        schemas_.reset();
+        if (!schema_file_.empty() && fs::exists(schema_file_)) {
+            auto schemas = std::make_shared<finance::SchemaRegistry>();
+            schemas->load(schema_file_);
+            schemas_ = std::move(schemas);
+        }
+        
+        if (streaming_) {
+            runStreaming(rules);
+            return;
+        }
+        
         // Load and preprocess expense data
-        finance::DataLoader data_loader(directory_);
-        auto all_expenses = data_loader.loadAndPreprocessData();
-        if (all_expenses.empty()) {
+        finance::InputManifest manifest;
+        bool outputs_current = false;
+        finance::TimeBuckets kept_totals;
+        auto kept_cube = std::make_shared<finance::ExpenseCube>();
+        bool append_only = false;
+        std::vector<finance::Expense> all_expenses;
+        if (incremental_) {
+            all_expenses = loadIncrementally(manifest, outputs_current, kept_totals, *kept_cube,
+                                             append_only);
+        } else {
+            finance::DataLoader data_loader(directory_, true, thread_count_);
+            data_loader.setSchemaRegistry(schemas_);
+            all_expenses = data_loader.loadAndPreprocessData();
+        }
+        if (outputs_current && !hot_reload_) {
+            std::cout << "Inputs unchanged since last run; outputs are up to date" << std::endl;
+            return;
+        }
+        if (all_expenses.empty() && !append_only) {
             throw std::runtime_error("No expense data found");
         }
         
-        // categorise expenses
-        finance::TransactionCategorisation categoriser(keyword_map);
-        categoriser.categoriseExpenses(all_expenses);
+        std::unique_ptr<finance::RuleStats> rule_stats;
+        if (categorisation_stats_ && !outputs_current) {
+            rule_stats = std::make_unique<finance::RuleStats>(rules->keywordCount());
+        }
+        
+        // Keep the rows indexed by deciding keyword for reloadKeywords()
+        if (hot_reload_) {
+            category_index_ = std::make_unique<finance::CategoryIndex>(
+                std::move(all_expenses), rules->keywordMap(), rule_stats.get());
+        }
+        if (outputs_current) {
+            std::cout << "Inputs unchanged since last run; outputs are up to date" << std::endl;
+            return;
+        }
+        
+        if (category_index_) {
+            writeOutputs(category_index_->expenses(), category_index_.get());
+            if (rule_stats) {
+                writeRuleStats(*rule_stats, finance::TransactionCategorisation(rules));
+            }
+        } else {
+            // categorise expenses
+            finance::TransactionCategorisation categoriser(rules);
+            auto memo = openCategoryMemo(categoriser);
+            categoriser.setRuleStats(rule_stats.get());
+            categoriser.categoriseExpenses(all_expenses, thread_count_);
+            saveCategoryMemo(memo.get());
+            
+            if (append_only) {
+                appendOutputs(all_expenses, kept_totals, std::move(kept_cube), manifest);
+            } else {
+                writeOutputs(all_expenses, nullptr);
+            }
+            if (rule_stats) {
+                writeRuleStats(*rule_stats, categoriser);
+            }
+        }
         
-        // Generate reports and export data
-        finance::ReportGenerator report_gen(output_dir_);
-        report_gen.generateReports(all_expenses);
+        // Record the inputs only once the outputs have been written
+        if (incremental_) {
+            if (!append_only) {
+                saveSummaryTotals(category_index_ ? category_index_->expenses() : all_expenses, manifest);
+            }
+            manifest.save((fs::path(output_dir_) / CACHE_DIRECTORY / MANIFEST_FILE).string());
+        }
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+bool FinanceProcessor::reloadKeywords() {
+    if (!category_index_) {
+        return false;
+    }
+    
+    try {
+        finance::KeywordLoader loader(keyword_file_);
+        auto keyword_map = loader.loadKeywords();
         
-        // Export data with user-specified options
-        finance::DataExporter exporter(output_dir_, 
-                                     export_monthly_summary_,
-                                     export_weekly_summary_,
-                                     export_full_dataset_);
-        exporter.exportData(all_expenses);
+        auto stats = category_index_->reload(keyword_map);
+        std::cout << "Keywords reloaded: " << stats.rows_changed << " of "
+                  << stats.rows_checked << " rechecked expenses changed" << std::endl;
+        if (stats.rows_changed > 0) {
+            writeOutputs(category_index_->expenses(), category_index_.get());
+        }
         
+        // The outputs now match the edited keyword file
+        if (incremental_) {
+            std::string manifest_path = (fs::path(output_dir_) / CACHE_DIRECTORY / MANIFEST_FILE).string();
+            finance::InputManifest manifest;
+            if (manifest.load(manifest_path) &&
+                finance::hashFileContents(keyword_file_, manifest.keyword_hash)) {
+                saveSummaryTotals(category_index_->expenses(), manifest);
+                manifest.save(manifest_path);
+            }
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         throw;
     }
-} 
\ No newline at end of file
+    return true;
+}
+
+void FinanceProcessor::writeOutputs(const std::vector<finance::Expense>& expenses,
+                                    const finance::CategoryIndex* index) {
+    // Kept summary totals and cube stop matching the outputs once these are
+    // rewritten
+    if (incremental_) {
+        fs::remove(summaryTotalsPath());
+        fs::remove(expenseCubePath());
+    }
+    
+    // Generate reports and export data
+    finance::ReportGenerator report_gen(output_dir_);
+    report_gen.generateReports(expenses);
+    
+    // Export data with user-specified options
+    finance::DataExporter exporter(output_dir_, 
+                                 export_monthly_summary_,
+                                 export_weekly_summary_,
+                                 export_full_dataset_);
+    if (index) {
+        exporter.exportData(expenses, index->totals());
+    } else {
+        exporter.exportData(expenses);
+    }
+    cube_ = exporter.cube();
+}
+
+void FinanceProcessor::appendOutputs(const std::vector<finance::Expense>& expenses,
+                                     finance::TimeBuckets& kept_totals,
+                                     std::shared_ptr<finance::ExpenseCube> kept_cube,
+                                     const finance::InputManifest& manifest) {
+    // Until the totals are saved again a failed append leaves none to reuse,
+    // so the next run rebuilds every output
+    fs::remove(summaryTotalsPath());
+    fs::remove(expenseCubePath());
+    
+    // The full report is written by ReportGenerator in full runs, so the
+    // exporter always appends to the categorised transactions
+    finance::DataExporter exporter(output_dir_,
+                                   export_monthly_summary_,
+                                   export_weekly_summary_,
+                                   true);
+    if (!exporter.appendData(expenses, kept_totals, std::move(kept_cube))) {
+        throw std::runtime_error("Kept summary totals do not match the summaries");
+    }
+    cube_ = exporter.cube();
+    saveSummaryTotals(kept_totals, manifest);
+    std::cout << "Appended " << expenses.size() << " expenses from new inputs" << std::endl;
+}
+
+void FinanceProcessor::saveSummaryTotals(const std::vector<finance::Expense>& expenses,
+                                         const finance::InputManifest& manifest) const {
+    finance::DataExporter exporter(output_dir_, export_monthly_summary_, export_weekly_summary_);
+    saveSummaryTotals(exporter.summaryTotals(expenses), manifest);
+}
+
+void FinanceProcessor::saveSummaryTotals(const finance::TimeBuckets& totals,
+                                         const finance::InputManifest& manifest) const {
+    try {
+        totals.save(summaryTotalsPath(), manifest.contentHash());
+        if (cube_) {
+            cube_->save(expenseCubePath(), manifest.contentHash());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Could not save summary totals: " << e.what() << std::endl;
+    }
+}
+
+std::string FinanceProcessor::summaryTotalsPath() const {
+    return (fs::path(output_dir_) / CACHE_DIRECTORY / SUMMARY_TOTALS_FILE).string();
+}
+
+std::string FinanceProcessor::expenseCubePath() const {
+    return (fs::path(output_dir_) / CACHE_DIRECTORY / EXPENSE_CUBE_FILE).string();
+}
+
+void FinanceProcessor::writeRuleStats(const finance::RuleStats& rule_stats,
+                                      const finance::TransactionCategorisation& categoriser) const {
+    rule_stats.writeCsv((fs::path(output_dir_) / "categorisation_stats.csv").string(), categoriser);
+    rule_stats.writeSummaryJson((fs::path(output_dir_) / "categorisation_stats.json").string());
+    std::cout << "Categorised " << rule_stats.rows() << " expenses in "
+              << rule_stats.matchSeconds() * 1000.0 << " ms; "
+              << rule_stats.deadRules() << " of " << rule_stats.ruleCount()
+              << " keywords never matched" << std::endl;
+}
+
+std::unique_ptr<finance::CategoryMemo> FinanceProcessor::openCategoryMemo(
+    finance::TransactionCategorisation& categoriser) const {
+    if (!incremental_) {
+        return nullptr;
+    }
+    
+    auto memo = std::make_unique<finance::CategoryMemo>(categoriser.rulesFingerprint());
+    memo->load((fs::path(output_dir_) / CACHE_DIRECTORY / CATEGORY_MEMO_FILE).string());
+    categoriser.setMemo(memo.get());
+    return memo;
+}
+
+void FinanceProcessor::saveCategoryMemo(const finance::CategoryMemo* memo) const {
+    if (!memo || !memo->modified()) {
+        return;
+    }
+    
+    try {
+        fs::path cache_dir = fs::path(output_dir_) / CACHE_DIRECTORY;
+        fs::create_directories(cache_dir);
+        memo->save((cache_dir / CATEGORY_MEMO_FILE).string());
+    } catch (const std::exception& e) {
+        std::cerr << "Could not save category memo: " << e.what() << std::endl;
+    }
+}
+
+uint64_t FinanceProcessor::optionsHash() const {
+    std::string options = "monthly=" + std::to_string(export_monthly_summary_) +
+                          ",weekly=" + std::to_string(export_weekly_summary_) +
+                          ",full=" + std::to_string(export_full_dataset_) +
+                          ",schemas=" + finance::toHex(schemas_ ? schemas_->contentHash() : 0);
+    
+    // Stats are only written by a run that categorises, so asking for them
+    // must not count as up to date with outputs written without
+    if (categorisation_stats_) {
+        options += ",stats=1";
+    }
+    return finance::fnv1a64(options);
+}
+
+std::vector<finance::Expense> FinanceProcessor::loadIncrementally(
+    finance::InputManifest& manifest, bool& outputs_current,
+    finance::TimeBuckets& kept_totals, finance::ExpenseCube& kept_cube, bool& append_only) {
+    
+    fs::path cache_dir = fs::path(output_dir_) / CACHE_DIRECTORY;
+    fs::create_directories(cache_dir);
+    
+    finance::InputManifest previous;
+    const bool have_previous = previous.load((cache_dir / MANIFEST_FILE).string());
+    bool inputs_changed = !have_previous;
+    
+    manifest = finance::InputManifest();
+    if (!finance::hashFileContents(keyword_file_, manifest.keyword_hash)) {
+        throw std::runtime_error("Could not read keyword file: " + keyword_file_);
+    }
+    manifest.options_hash = optionsHash();
+    
+    // Note which files are new or changed since the manifest was written
+    finance::DataLoader data_loader(directory_, true, thread_count_);
+    data_loader.setSchemaRegistry(schemas_);
+    data_loader.setCacheDirectory(cache_dir.string());
+    std::vector<std::string> filepaths = data_loader.listInputFiles();
+    std::vector<std::string> added_files;
+    bool known_files_changed = false;
+    bool files_touched = false;
+    for (const auto& filepath : filepaths) {
+        auto known = previous.files.find(filepath);
+        const finance::FileFingerprint* before =
+            known != previous.files.end() ? &known->second : nullptr;
+        
+        finance::FileFingerprint current = finance::InputManifest::fingerprint(filepath, before);
+        manifest.files[filepath] = current;
+        if (!before) {
+            added_files.push_back(filepath);
+            inputs_changed = true;
+        } else if (before->size != current.size ||
+                   before->content_hash != current.content_hash) {
+            known_files_changed = true;
+            inputs_changed = true;
+        } else if (before->mtime != current.mtime) {
+            files_touched = true;
+        }
+    }
+    
+    // Drop caches of inputs that have been removed
+    for (const auto& [path, entry] : previous.files) {
+        if (manifest.files.count(path) == 0) {
+            fs::remove(data_loader.cachePathFor(path));
+            known_files_changed = true;
+            inputs_changed = true;
+        }
+    }
+    
+    // Outputs can be kept as they are only if nothing feeding them changed
+    bool outputs_exist =
+        fs::exists(fs::path(output_dir_) / "categorised_transactions.csv") &&
+        (!export_monthly_summary_ || fs::exists(fs::path(output_dir_) / "monthly_summary.csv")) &&
+        (!export_weekly_summary_ || fs::exists(fs::path(output_dir_) / "weekly_summary.csv"));
+    outputs_current = !inputs_changed &&
+                      outputs_exist &&
+                      previous.keyword_hash == manifest.keyword_hash &&
+                      previous.options_hash == manifest.options_hash;
+    
+    // Nothing needs redoing. Record new mtimes of files touched without
+    // changing, so they are not hashed again next run, and load no rows
+    // unless hot reload has to index them.
+    if (outputs_current) {
+        if (files_touched) {
+            manifest.save((cache_dir / MANIFEST_FILE).string());
+        }
+        if (!hot_reload_) {
+            return std::vector<finance::Expense>();
+        }
+    }
+    
+    // When files were only added, their rows can go onto the totals and cube
+    // kept for the previous inputs, so the other files need not be loaded.
+    // Rows are appended to categorised_transactions.csv, which keeps it in
+    // file name order only if every new file sorts after the known ones.
+    // Hot reload needs every row and stats cover every row, so both rebuild.
+    const bool added_at_end = !added_files.empty() && !previous.files.empty() &&
+                              added_files.front() > previous.files.rbegin()->first;
+    append_only = have_previous &&
+                  !known_files_changed &&
+                  added_at_end &&
+                  outputs_exist &&
+                  !hot_reload_ &&
+                  !categorisation_stats_ &&
+                  previous.keyword_hash == manifest.keyword_hash &&
+                  previous.options_hash == manifest.options_hash &&
+                  kept_totals.load(summaryTotalsPath(), previous.contentHash()) &&
+                  kept_cube.load(expenseCubePath(), previous.contentHash());
+    
+    // Unchanged files load from their columnar caches; the rest are parsed
+    // and their caches refreshed
+    auto file_expenses = data_loader.loadFiles(append_only ? added_files : filepaths);
+    
+    // Merge in file order, moving rows into one pre-sized result
+    size_t total = 0;
+    for (const auto& expenses : file_expenses) {
+        total += expenses.size();
+    }
+    std::vector<finance::Expense> all_expenses;
+    all_expenses.reserve(total);
+    for (auto& expenses : file_expenses) {
+        std::move(expenses.begin(), expenses.end(), std::back_inserter(all_expenses));
+    }
+    return all_expenses;
+}
+
+void FinanceProcessor::runStreaming(std::shared_ptr<const finance::RulePack> rules) {
+    // Batches in flight per queue; bounds memory to a few batches per stage
+    constexpr size_t QUEUE_CAPACITY = 4;
+    
+    using ExpenseBatch = std::vector<finance::Expense>;
+    finance::BoundedQueue<finance::DataLoader::RecordBatch> raw_queue(QUEUE_CAPACITY);
+    finance::BoundedQueue<ExpenseBatch> parsed_queue(QUEUE_CAPACITY);
+    finance::BoundedQueue<ExpenseBatch> categorised_queue(QUEUE_CAPACITY);
+    
+    finance::DataLoader data_loader(directory_, true, thread_count_);
+    data_loader.setSchemaRegistry(schemas_);
+    finance::TransactionCategorisation categoriser(std::move(rules));
+    auto memo = openCategoryMemo(categoriser);
+    std::unique_ptr<finance::RuleStats> rule_stats;
+    if (categorisation_stats_) {
+        rule_stats = std::make_unique<finance::RuleStats>(categoriser.keywordCount());
+        categoriser.setRuleStats(rule_stats.get());
+    }
+    
+    // The full report is always written in batch mode (ReportGenerator), so
+    // the streaming exporter always writes the categorised transactions
+    finance::DataExporter exporter(output_dir_,
+                                   export_monthly_summary_,
+                                   export_weekly_summary_,
+                                   true);
+    
+    // The first failure closes every queue so all stages unwind
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+    auto fail = [&](std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error) first_error = error;
+        }
+        raw_queue.close();
+        parsed_queue.close();
+        categorised_queue.close();
+    };
+    
+    std::thread reader([&] {
+        try {
+            data_loader.readRecordBatches(streaming_batch_size_,
+                [&](finance::DataLoader::RecordBatch&& batch) {
+                    return raw_queue.push(std::move(batch));
+                });
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        raw_queue.close();
+    });
+    
+    std::thread parser([&] {
+        try {
+            finance::DataLoader::RecordBatch batch;
+            while (raw_queue.pop(batch)) {
+                if (!parsed_queue.push(data_loader.parseRecordBatch(batch))) break;
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        parsed_queue.close();
+    });
+    
+    std::thread categoriser_stage([&] {
+        try {
+            ExpenseBatch batch;
+            while (parsed_queue.pop(batch)) {
+                categoriser.categoriseExpenses(batch);
+                if (!categorised_queue.push(std::move(batch))) break;
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        categorised_queue.close();
+    });
+    
+    // Aggregate and write on the calling thread
+    size_t expense_count = 0;
+    try {
+        exporter.begin();
+        ExpenseBatch batch;
+        while (categorised_queue.pop(batch)) {
+            exporter.add(batch);
+            expense_count += batch.size();
+        }
+        exporter.finish();
+        cube_ = exporter.cube();
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    
+    reader.join();
+    parser.join();
+    categoriser_stage.join();
+    
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+    saveCategoryMemo(memo.get());
+    if (expense_count == 0) {
+        throw std::runtime_error("No expense data found");
+    }
+    if (rule_stats) {
+        writeRuleStats(*rule_stats, categoriser);
+    }
+}
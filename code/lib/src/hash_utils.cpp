@@ -0,0 +1,38 @@
+#include "hash_utils.hpp"
+#include "mapped_file.hpp"
+#include <fstream>
+
+namespace finance {
+
+bool hashFileContents(const std::string& filepath, uint64_t& hash) {
+    MappedFile mapping;
+    if (mapping.open(filepath)) {
+        hash = fnv1a64(mapping.view());
+        return true;
+    }
+    
+    // Empty files, pipes and platforms without mmap
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    hash = FNV_OFFSET_BASIS;
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        hash = fnv1a64(std::string_view(buffer, static_cast<size_t>(file.gcount())), hash);
+    }
+    return true;
+}
+
+std::string toHex(uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        hex[i] = digits[value & 0xf];
+        value >>= 4;
+    }
+    return hex;
+}
+
+} // namespace finance
@@ -0,0 +1,107 @@
+#include "input_manifest.hpp"
+#include "hash_utils.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* MANIFEST_HEADER = "# finance input manifest v1";
+
+} // namespace
+
+bool InputManifest::load(const std::string& filepath) {
+    *this = InputManifest();
+    
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::string line;
+    if (!std::getline(file, line) || line != MANIFEST_HEADER) {
+        return false;
+    }
+    
+    try {
+        // Lines: "keywords,<hex>", "options,<hex>" and
+        // "file,<size>,<mtime>,<hex hash>,<path>" (path last, may hold commas)
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string kind;
+            std::getline(fields, kind, ',');
+            
+            if (kind == "keywords" || kind == "options") {
+                std::string hex;
+                std::getline(fields, hex);
+                (kind == "keywords" ? keyword_hash : options_hash) = std::stoull(hex, nullptr, 16);
+            } else if (kind == "file") {
+                std::string size, mtime, hash, path;
+                std::getline(fields, size, ',');
+                std::getline(fields, mtime, ',');
+                std::getline(fields, hash, ',');
+                std::getline(fields, path);
+                
+                FileFingerprint& entry = files[path];
+                entry.size = std::stoull(size);
+                entry.mtime = std::stoll(mtime);
+                entry.content_hash = std::stoull(hash, nullptr, 16);
+            }
+        }
+    } catch (const std::exception&) {
+        *this = InputManifest();
+        return false;
+    }
+    
+    return true;
+}
+
+void InputManifest::save(const std::string& filepath) const {
+    // Write to a temporary file first so a crash never leaves a torn manifest
+    std::string temp_path = filepath + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        
+        file << MANIFEST_HEADER << "\n";
+        file << "keywords," << toHex(keyword_hash) << "\n";
+        file << "options," << toHex(options_hash) << "\n";
+        for (const auto& [path, entry] : files) {
+            file << "file," << entry.size << "," << entry.mtime << ","
+                 << toHex(entry.content_hash) << "," << path << "\n";
+        }
+    }
+    fs::rename(temp_path, filepath);
+}
+
+FileFingerprint InputManifest::fingerprint(const std::string& filepath,
+                                           const FileFingerprint* previous) {
+    FileFingerprint result;
+    result.size = fs::file_size(filepath);
+    result.mtime = static_cast<int64_t>(fs::last_write_time(filepath).time_since_epoch().count());
+    
+    if (previous && previous->size == result.size && previous->mtime == result.mtime) {
+        result.content_hash = previous->content_hash;
+    } else if (!hashFileContents(filepath, result.content_hash)) {
+        throw std::runtime_error("Could not read file: " + filepath);
+    }
+    
+    return result;
+}
+
+uint64_t InputManifest::contentHash() const {
+    std::string text = toHex(keyword_hash) + "," + toHex(options_hash) + "\n";
+    for (const auto& [path, entry] : files) {
+        text += std::to_string(entry.size) + "," + toHex(entry.content_hash) + "," + path + "\n";
+    }
+    return fnv1a64(text);
+}
+
+} // namespace finance
@@ -1,5 +1,8 @@
 #include "keyword_loader.hpp"
 #include "csv_parser.hpp"
+#include "hash_utils.hpp"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <iostream>
 
@@ -22,11 +25,11 @@ std::map<std::string, std::string> KeywordLoader::loadKeywords() {
         std::getline(file, line);
         
         // Process each line
+        CSVTokenizer fields;
         while (std::getline(file, line)) {
-            auto fields = CSVParser::parseLine(line);
-            if (fields.size() >= 2) {
-                std::string category = fields[0];
-                std::string keyword = fields[1];
+            if (fields.tokenize(line) >= 2) {
+                std::string category(fields[0]);
+                std::string keyword(fields[1]);
                 
                 // Convert keyword to lowercase for case-insensitive matching
                 std::transform(keyword.begin(), keyword.end(), keyword.begin(),
@@ -47,4 +50,33 @@ std::map<std::string, std::string> KeywordLoader::loadKeywords() {
     return keyword_map;
 }
 
+std::shared_ptr<const RulePack> KeywordLoader::loadRulePack(const std::string& pack_path) {
+    uint64_t source_hash = 0;
+    if (!hashFileContents(filepath_, source_hash)) {
+        throw std::runtime_error("Could not open keyword mapping file");
+    }
+    
+    // A pack built from these exact contents needs no parsing at all
+    auto pack = std::make_shared<RulePack>();
+    if (!pack_path.empty() && pack->load(pack_path, source_hash)) {
+        return pack;
+    }
+    
+    std::string bytes = RulePack::compile(loadKeywords(), source_hash);
+    if (!pack_path.empty()) {
+        try {
+            RulePack::save(pack_path, bytes);
+            if (pack->load(pack_path, source_hash)) {
+                return pack;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Could not save rule pack: " << e.what() << std::endl;
+        }
+    }
+    if (!pack->assign(std::move(bytes), source_hash)) {
+        throw std::runtime_error("Failed to compile keyword mapping");
+    }
+    return pack;
+}
+
 } // namespace finance 
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "keyword_matcher.hpp"
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+namespace finance {
+
+namespace {
+
+inline unsigned char foldByte(unsigned char c) {
+    return static_cast<unsigned char>(std::tolower(c));
+}
+
+} // namespace
+
+KeywordMatcher::KeywordMatcher(const std::map<std::string, std::string>& keyword_map) {
+    // Give each byte used by a keyword its own class; both cases of a letter
+    // share one, so text is folded by the class lookup itself
+    for (const auto& entry : keyword_map) {
+        for (unsigned char c : entry.first) {
+            unsigned char folded = foldByte(c);
+            if (byte_class_[folded] == 0) {
+                byte_class_[folded] = static_cast<uint16_t>(class_count_++);
+            }
+        }
+    }
+    for (int c = 0; c < 256; ++c) {
+        byte_class_[c] = byte_class_[foldByte(static_cast<unsigned char>(c))];
+    }
+    
+    // Build the trie; child 0 means "no edge" since the root is never a child
+    owned_transitions_.assign(class_count_, 0);
+    owned_best_rank_.assign(1, NO_MATCH);
+    for (const auto& [keyword, category] : keyword_map) {
+        uint32_t rank = static_cast<uint32_t>(categories_.size());
+        categories_.push_back(Symbol::intern(category));
+        
+        if (keyword.empty()) {
+            empty_rank_ = std::min(empty_rank_, rank);
+            continue;
+        }
+        
+        uint32_t state = 0;
+        for (unsigned char c : keyword) {
+            size_t edge = static_cast<size_t>(state) * class_count_ + byte_class_[c];
+            if (owned_transitions_[edge] == 0) {
+                owned_transitions_[edge] = static_cast<uint32_t>(owned_best_rank_.size());
+                owned_best_rank_.push_back(NO_MATCH);
+                owned_transitions_.resize(owned_transitions_.size() + class_count_, 0);
+            }
+            state = owned_transitions_[edge];
+        }
+        owned_best_rank_[state] = std::min(owned_best_rank_[state], rank);
+    }
+    
+    // Breadth-first pass turning the trie into a complete DFA: missing edges
+    // follow the failure link and each state inherits its suffix's best rank
+    std::vector<uint32_t> failure(owned_best_rank_.size(), 0);
+    std::queue<uint32_t> pending;
+    for (uint32_t c = 0; c < class_count_; ++c) {
+        uint32_t child = owned_transitions_[c];
+        if (child != 0) {
+            pending.push(child);
+        }
+    }
+    while (!pending.empty()) {
+        uint32_t state = pending.front();
+        pending.pop();
+        for (uint32_t c = 0; c < class_count_; ++c) {
+            uint32_t& next = owned_transitions_[static_cast<size_t>(state) * class_count_ + c];
+            uint32_t fallback = owned_transitions_[static_cast<size_t>(failure[state]) * class_count_ + c];
+            if (next == 0) {
+                next = fallback;
+                continue;
+            }
+            failure[next] = fallback;
+            owned_best_rank_[next] = std::min(owned_best_rank_[next], owned_best_rank_[fallback]);
+            pending.push(next);
+        }
+    }
+    
+    transitions_ = owned_transitions_.data();
+    best_rank_ = owned_best_rank_.data();
+    state_count_ = owned_best_rank_.size();
+}
+
+KeywordMatcher::KeywordMatcher(const Tables& tables, std::vector<Symbol> categories)
+    : class_count_(tables.class_count)
+    , transitions_(tables.transitions)
+    , best_rank_(tables.best_rank)
+    , state_count_(tables.state_count)
+    , categories_(std::move(categories))
+    , empty_rank_(tables.empty_rank) {
+    std::copy(tables.byte_class, tables.byte_class + byte_class_.size(), byte_class_.begin());
+}
+
+KeywordMatcher::Tables KeywordMatcher::tables() const {
+    return Tables{byte_class_.data(), class_count_, transitions_, best_rank_,
+                  state_count_, empty_rank_};
+}
+
+uint32_t KeywordMatcher::firstMatch(std::string_view text) const {
+    uint32_t best = empty_rank_;
+    uint32_t state = 0;
+    for (unsigned char c : text) {
+        state = transitions_[static_cast<size_t>(state) * class_count_ + byte_class_[c]];
+        best = std::min(best, best_rank_[state]);
+        if (best == 0) {
+            break;  // Nothing can come earlier in map order
+        }
+    }
+    return best;
+}
+
+const Symbol* KeywordMatcher::findCategory(std::string_view text) const {
+    uint32_t rank = firstMatch(text);
+    return rank == NO_MATCH ? nullptr : &categories_[rank];
+}
+
+} // namespace finance
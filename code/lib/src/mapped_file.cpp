@@ -0,0 +1,74 @@
+#include "mapped_file.hpp"
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FINANCE_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace finance {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filepath) {
+    close();
+    
+#ifdef FINANCE_HAVE_MMAP
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // Only regular, non-empty files can be mapped
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference to the file
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(mapping);
+    size_ = size;
+    return true;
+#else
+    (void)filepath;
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef FINANCE_HAVE_MMAP
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace finance
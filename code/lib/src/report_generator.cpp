@@ -1,9 +1,11 @@
 #include "report_generator.hpp"
+#include "transaction_parser.hpp"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <unordered_map>
 
 namespace finance {
 
@@ -21,55 +23,54 @@ void ReportGenerator::generateReports(const std::vector<Expense>& expenses) {
 }
 
 void ReportGenerator::generateFullReport(const std::vector<Expense>& expenses) {
-    // Create output file with fixed name
+    // Create output file with fixed name; rows are formatted while the
+    // previous buffer is written
     std::string filepath = fs::path(output_dir_) / "categorised_transactions.csv";
-    std::ofstream file(filepath);
-    
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not create full report file: " + filepath);
-    }
-    
-    // Write header
-    file << "Date,Month,FileOrigin,Description,Amount,Currency,Category\n";
-    
-    // Write expenses
+    CsvWriter writer(filepath, CsvWriter::Mode::Truncate, true);
+    writeTransactionHeader(writer);
+    writeTransactions(writer, expenses);
+    writer.close();
+}
+
+void ReportGenerator::writeTransactionHeader(CsvWriter& writer) {
+    writer.field("Date").field("Month").field("FileOrigin").field("Description")
+          .field("Amount").field("Currency").field("Category");
+    writer.endRow();
+}
+
+void ReportGenerator::writeTransactions(CsvWriter& writer, const std::vector<Expense>& expenses) {
     for (const auto& expense : expenses) {
-        // Format date
-        auto time = std::chrono::system_clock::to_time_t(expense.date);
-        std::tm tm = *std::localtime(&time);
-        char date_str[11];
-        std::strftime(date_str, sizeof(date_str), "%d/%m/%Y", &tm);
-        
-        file << date_str << ","
-             << expense.month << ","
-             << expense.file_origin << ","
-             << expense.description << ","
-             << std::fixed << std::setprecision(2) << std::abs(expense.amount) << ","
-             << currencyToSymbol(expense.currency) << ","
-             << expense.category << "\n";
+        writer.dayMonthYearField(expense.date)
+              .monthField(expense.date)
+              .field(expense.file_origin)
+              .field(expense.description)
+              .field(expense.amount.abs())
+              .field(currencyToSymbol(expense.currency))
+              .field(expense.category);
+        writer.endRow();
     }
 }
 
-std::map<std::string, double> ReportGenerator::calculateCategoryTotals(
+std::map<std::string, Money> ReportGenerator::calculateCategoryTotals(
     const std::vector<Expense>& expenses) {
     
-    std::map<std::string, double> totals;
+    // Group by category id, then key the result by name
+    std::unordered_map<uint32_t, std::pair<Symbol, Money>> by_category;
     
     for (const auto& expense : expenses) {
         // Skip expenses with unknown currency
         if (expense.currency == Currency::UNKNOWN) continue;
         
         // Convert to GBP if necessary (simplified conversion)
-        double amount_gbp = expense.amount;
-        if (expense.currency == Currency::EUR) {
-            amount_gbp *= 0.86;  // Approximate EUR to GBP conversion
-        } else if (expense.currency == Currency::USD) {
-            amount_gbp *= 0.79;  // Approximate USD to GBP conversion
-        }
-        
-        totals[expense.category] += amount_gbp;
+        auto& [category, total] = by_category[expense.category.id()];
+        category = expense.category;
+        total += toGbp(expense.amount, expense.currency);
     }
     
+    std::map<std::string, Money> totals;
+    for (const auto& [id, entry] : by_category) {
+        totals.emplace(entry.first.str(), entry.second);
+    }
     return totals;
 }
 
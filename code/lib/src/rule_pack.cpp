@@ -0,0 +1,292 @@
+#include "rule_pack.hpp"
+#include "hash_utils.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char PACK_MAGIC[8] = {'F', 'I', 'N', 'R', 'U', 'L', 'E', 'S'};
+constexpr uint32_t PACK_VERSION = 1;
+constexpr uint32_t NO_MATCH = KeywordMatcher::NO_MATCH;
+
+enum Section : size_t {
+    BYTE_CLASSES,     // uint16[256]
+    TRANSITIONS,      // uint32[state_count * class_count]
+    BEST_RANKS,       // uint32[state_count]
+    RULE_CATEGORIES,  // uint32[keyword_count] ids into CATEGORIES
+    KEYWORDS,         // uint32 offsets[keyword_count + 1], bytes
+    CATEGORIES,       // uint32 offsets[category_count + 1], bytes
+    SECTION_COUNT
+};
+
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t class_count;
+    uint64_t source_hash;       // Hash of the keyword file contents
+    uint64_t rules_fingerprint;
+    uint64_t state_count;
+    uint32_t keyword_count;
+    uint32_t category_count;
+    uint32_t empty_rank;
+    uint32_t reserved;
+    uint64_t file_size;
+    uint64_t checksum;          // FNV-1a of everything after the header
+    uint64_t section_offsets[SECTION_COUNT];
+};
+
+void alignTo8(std::string& out) {
+    out.resize((out.size() + 7) & ~size_t{7}, '\0');
+}
+
+template <typename T>
+void appendArray(std::string& out, const T* values, size_t count) {
+    out.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+template <typename Strings>
+void appendStrings(std::string& out, const Strings& strings) {
+    uint32_t offset = 0;
+    appendArray(out, &offset, 1);
+    for (const auto& value : strings) {
+        offset += static_cast<uint32_t>(value.size());
+        appendArray(out, &offset, 1);
+    }
+    for (const auto& value : strings) {
+        out.append(value.data(), value.size());
+    }
+}
+
+// Array of count values of T at a section, or nullptr if out of bounds
+template <typename T>
+const T* sectionArray(std::string_view bytes, uint64_t offset, uint64_t count) {
+    if (offset % alignof(T) != 0 || offset > bytes.size() ||
+        count > (bytes.size() - offset) / sizeof(T)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const T*>(bytes.data() + offset);
+}
+
+} // namespace
+
+uint64_t keywordRulesFingerprint(const std::map<std::string, std::string>& keyword_map) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const auto& [keyword, category] : keyword_map) {
+        hash = fnv1a64(keyword, hash);
+        hash = fnv1a64(std::string_view("\0", 1), hash);
+        hash = fnv1a64(category, hash);
+        hash = fnv1a64(std::string_view("\n", 1), hash);
+    }
+    return hash;
+}
+
+std::string RulePack::compile(const std::map<std::string, std::string>& keyword_map,
+                              uint64_t source_hash) {
+    KeywordMatcher matcher(keyword_map);
+    KeywordMatcher::Tables tables = matcher.tables();
+
+    // Distinct categories in order of first use
+    std::vector<std::string_view> categories;
+    std::unordered_map<std::string_view, uint32_t> category_ids;
+    std::vector<uint32_t> rule_categories;
+    std::vector<std::string_view> keywords;
+    rule_categories.reserve(keyword_map.size());
+    keywords.reserve(keyword_map.size());
+    for (const auto& [keyword, category] : keyword_map) {
+        auto [it, inserted] = category_ids.emplace(category, static_cast<uint32_t>(categories.size()));
+        if (inserted) {
+            categories.push_back(category);
+        }
+        rule_categories.push_back(it->second);
+        keywords.push_back(keyword);
+    }
+
+    PackHeader header = {};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.class_count = tables.class_count;
+    header.source_hash = source_hash;
+    header.rules_fingerprint = keywordRulesFingerprint(keyword_map);
+    header.state_count = tables.state_count;
+    header.keyword_count = static_cast<uint32_t>(keywords.size());
+    header.category_count = static_cast<uint32_t>(categories.size());
+    header.empty_rank = tables.empty_rank;
+
+    // Lay out 8-byte aligned sections after the header
+    std::string out(sizeof(PackHeader), '\0');
+    auto beginSection = [&](Section section) {
+        alignTo8(out);
+        header.section_offsets[section] = out.size();
+    };
+    beginSection(BYTE_CLASSES);
+    appendArray(out, tables.byte_class, 256);
+    beginSection(TRANSITIONS);
+    appendArray(out, tables.transitions, tables.state_count * tables.class_count);
+    beginSection(BEST_RANKS);
+    appendArray(out, tables.best_rank, tables.state_count);
+    beginSection(RULE_CATEGORIES);
+    appendArray(out, rule_categories.data(), rule_categories.size());
+    beginSection(KEYWORDS);
+    appendStrings(out, keywords);
+    beginSection(CATEGORIES);
+    appendStrings(out, categories);
+
+    header.file_size = out.size();
+    header.checksum = fnv1a64(std::string_view(out).substr(sizeof(header)));
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+void RulePack::save(const std::string& filepath, const std::string& bytes) {
+    // Write to a temporary file first so readers never map a torn pack
+    std::string temp_path = filepath + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    fs::rename(temp_path, filepath);
+}
+
+bool RulePack::load(const std::string& filepath, uint64_t source_hash) {
+    clear();
+    if (!mapping_.open(filepath)) {
+        return false;
+    }
+    bytes_ = mapping_.view();
+    if (!open(source_hash)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool RulePack::assign(std::string bytes, uint64_t source_hash) {
+    clear();
+    owned_bytes_ = std::move(bytes);
+    bytes_ = owned_bytes_;
+    if (!open(source_hash)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void RulePack::clear() {
+    mapping_.close();
+    owned_bytes_.clear();
+    bytes_ = std::string_view();
+    tables_ = KeywordMatcher::Tables{};
+    rule_categories_ = nullptr;
+    keywords_ = StringTable();
+    categories_ = StringTable();
+    rules_fingerprint_ = 0;
+}
+
+bool RulePack::open(uint64_t source_hash) {
+    PackHeader header;
+    if (bytes_.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, bytes_.data(), sizeof(header));
+    if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+        header.version != PACK_VERSION ||
+        header.source_hash != source_hash ||
+        header.file_size != bytes_.size() ||
+        header.class_count == 0 || header.class_count > 257 ||
+        header.state_count == 0 || header.state_count > bytes_.size() ||
+        fnv1a64(bytes_.substr(sizeof(header))) != header.checksum) {
+        return false;
+    }
+
+    auto byte_class = sectionArray<uint16_t>(bytes_, header.section_offsets[BYTE_CLASSES], 256);
+    auto transitions = sectionArray<uint32_t>(bytes_, header.section_offsets[TRANSITIONS],
+                                              header.state_count * header.class_count);
+    auto best_rank = sectionArray<uint32_t>(bytes_, header.section_offsets[BEST_RANKS],
+                                            header.state_count);
+    auto rule_categories = sectionArray<uint32_t>(bytes_, header.section_offsets[RULE_CATEGORIES],
+                                                  header.keyword_count);
+    if (!byte_class || !transitions || !best_rank || !rule_categories) {
+        return false;
+    }
+
+    // The matcher indexes with these values unchecked, so every one must be
+    // in range
+    for (size_t c = 0; c < 256; ++c) {
+        if (byte_class[c] >= header.class_count) return false;
+    }
+    for (uint64_t i = 0; i < header.state_count * header.class_count; ++i) {
+        if (transitions[i] >= header.state_count) return false;
+    }
+    for (uint64_t i = 0; i < header.state_count; ++i) {
+        if (best_rank[i] != NO_MATCH && best_rank[i] >= header.keyword_count) return false;
+    }
+    for (uint32_t i = 0; i < header.keyword_count; ++i) {
+        if (rule_categories[i] >= header.category_count) return false;
+    }
+    if (header.empty_rank != NO_MATCH && header.empty_rank >= header.keyword_count) {
+        return false;
+    }
+
+    auto stringTable = [&](Section section, uint32_t count, StringTable& table) {
+        uint64_t offset = header.section_offsets[section];
+        auto offsets = sectionArray<uint32_t>(bytes_, offset, uint64_t{count} + 1);
+        if (!offsets) {
+            return false;
+        }
+        uint64_t bytes_offset = offset + sizeof(uint32_t) * (uint64_t{count} + 1);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > bytes_.size() - bytes_offset) {
+                return false;
+            }
+        }
+        table.offsets = offsets;
+        table.bytes = bytes_.data() + bytes_offset;
+        table.count = count;
+        return true;
+    };
+    if (!stringTable(KEYWORDS, header.keyword_count, keywords_) ||
+        !stringTable(CATEGORIES, header.category_count, categories_)) {
+        return false;
+    }
+
+    tables_ = KeywordMatcher::Tables{byte_class, header.class_count, transitions, best_rank,
+                                     static_cast<size_t>(header.state_count), header.empty_rank};
+    rule_categories_ = rule_categories;
+    rules_fingerprint_ = header.rules_fingerprint;
+    return true;
+}
+
+KeywordMatcher RulePack::matcher() const {
+    // Intern each distinct category once, then spread them over the ranks
+    std::vector<Symbol> category_symbols;
+    category_symbols.reserve(categories_.count);
+    for (uint32_t i = 0; i < categories_.count; ++i) {
+        category_symbols.push_back(Symbol::intern(categories_[i]));
+    }
+    std::vector<Symbol> categories(keywords_.count);
+    for (uint32_t rank = 0; rank < keywords_.count; ++rank) {
+        categories[rank] = category_symbols[rule_categories_[rank]];
+    }
+    return KeywordMatcher(tables_, std::move(categories));
+}
+
+std::map<std::string, std::string> RulePack::keywordMap() const {
+    std::map<std::string, std::string> keyword_map;
+    for (uint32_t rank = 0; rank < keywords_.count; ++rank) {
+        keyword_map.emplace_hint(keyword_map.end(), std::string(keywords_[rank]),
+                                 std::string(categories_[rule_categories_[rank]]));
+    }
+    return keyword_map;
+}
+
+} // namespace finance
@@ -0,0 +1,125 @@
+#include "rule_stats.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace finance {
+
+namespace {
+
+// Field quoted only if it holds a comma, quote or line break
+void writeCsvField(std::ostream& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out << field;
+        return;
+    }
+    out << '"';
+    for (char c : field) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+RuleStats::RuleStats(size_t rule_count)
+    : rules_(rule_count) {}
+
+void RuleStats::record(const CategoryDecision& decision, const Expense& expense) {
+    ++rows_;
+    if (decision.rule == CategoryDecision::NO_RULE) {
+        ++uncategorised_;
+        return;
+    }
+
+    Rule& rule = rules_[decision.rule];
+    if (rule.hits == 0 || expense.date < rule.first_match) {
+        rule.first_match = expense.date;
+    }
+    if (rule.hits == 0 || rule.last_match < expense.date) {
+        rule.last_match = expense.date;
+    }
+    ++rule.hits;
+    if (decision.by_name) {
+        ++rule.name_hits;
+    }
+
+    Symbol text = decision.by_name ? expense.name : expense.description;
+    if (rule.examples.size() < MAX_EXAMPLES &&
+        std::find(rule.examples.begin(), rule.examples.end(), text) == rule.examples.end()) {
+        rule.examples.push_back(text);
+    }
+}
+
+void RuleStats::addMatchTime(std::chrono::steady_clock::duration elapsed) {
+    match_time_ += elapsed;
+}
+
+size_t RuleStats::deadRules() const {
+    return static_cast<size_t>(std::count_if(rules_.begin(), rules_.end(),
+                                             [](const Rule& rule) { return rule.hits == 0; }));
+}
+
+double RuleStats::matchSeconds() const {
+    return std::chrono::duration<double>(match_time_).count();
+}
+
+double RuleStats::rowsPerSecond() const {
+    double seconds = matchSeconds();
+    return seconds > 0 ? static_cast<double>(rows_) / seconds : 0.0;
+}
+
+void RuleStats::writeCsv(const std::string& filepath,
+                         const TransactionCategorisation& categoriser) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create file: " + filepath);
+    }
+
+    file << "Rank,Keyword,Category,Hits,NameHits,FirstMatch,LastMatch,Examples\n";
+    for (uint32_t rank = 0; rank < rules_.size(); ++rank) {
+        const Rule& rule = rules_[rank];
+        file << rank << ',';
+        writeCsvField(file, categoriser.keyword(rank));
+        file << ',';
+        writeCsvField(file, categoriser.category(rank).view());
+        file << ',' << rule.hits << ',' << rule.name_hits << ',';
+        if (rule.hits > 0) {
+            file << rule.first_match.formatIso() << ',' << rule.last_match.formatIso();
+        } else {
+            file << ',';
+        }
+        file << ',';
+
+        std::string examples;
+        for (Symbol example : rule.examples) {
+            if (!examples.empty()) examples += " | ";
+            examples += example.view();
+        }
+        writeCsvField(file, examples);
+        file << '\n';
+    }
+}
+
+void RuleStats::writeSummaryJson(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create file: " + filepath);
+    }
+
+    file << "{\n"
+         << "  \"rows\": " << rows_ << ",\n"
+         << "  \"matched\": " << rows_ - uncategorised_ << ",\n"
+         << "  \"uncategorised\": " << uncategorised_ << ",\n"
+         << "  \"rules\": " << rules_.size() << ",\n"
+         << "  \"dead_rules\": " << deadRules() << ",\n"
+         << std::fixed << std::setprecision(6)
+         << "  \"match_seconds\": " << matchSeconds() << ",\n"
+         << std::setprecision(0)
+         << "  \"rows_per_second\": " << rowsPerSecond() << "\n"
+         << "}\n";
+}
+
+} // namespace finance
@@ -0,0 +1,117 @@
+#include "schema_registry.hpp"
+#include "csv_parser.hpp"
+#include "hash_utils.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace finance {
+
+namespace {
+
+int parseColumn(std::string_view field, const std::string& profile) {
+    try {
+        int column = std::stoi(std::string(field));
+        if (column >= -1) {
+            return column;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("Invalid column number '" + std::string(field) +
+                             "' in schema profile " + profile);
+}
+
+} // namespace
+
+void SchemaRegistry::load(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open schema file: " + filepath);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+    
+    profiles_.clear();
+    content_hash_ = fnv1a64(text);
+    
+    std::istringstream lines(text);
+    std::string line;
+    // Skip header
+    std::getline(lines, line);
+    
+    CSVTokenizer fields;
+    while (std::getline(lines, line)) {
+        if (fields.tokenize(line) < 9 || fields[0].empty()) {
+            continue;
+        }
+        
+        SchemaProfile profile;
+        profile.name = std::string(fields[0]);
+        
+        uint64_t header_fingerprint = 0;
+        try {
+            header_fingerprint = std::stoull(std::string(fields[1]), nullptr, 16);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid fingerprint in schema profile " + profile.name);
+        }
+        
+        profile.cols.date_col = parseColumn(fields[2], profile.name);
+        profile.cols.description_col = parseColumn(fields[3], profile.name);
+        profile.cols.amount_col = parseColumn(fields[4], profile.name);
+        profile.cols.name_col = parseColumn(fields[5], profile.name);
+        profile.currency_col = parseColumn(fields[6], profile.name);
+        if (profile.cols.date_col == -1 || profile.cols.description_col == -1 ||
+            profile.cols.amount_col == -1) {
+            throw std::runtime_error("Schema profile " + profile.name +
+                                     " needs date, description and amount columns");
+        }
+        
+        std::string sign = CSVParser::cleanField(fields[7]);
+        if (sign == "as-is") {
+            profile.sign = SignConvention::AsIs;
+        } else if (sign == "negate") {
+            profile.sign = SignConvention::Negate;
+        } else {
+            throw std::runtime_error("Unknown sign convention in schema profile " + profile.name);
+        }
+        
+        std::string date_format = CSVParser::cleanField(fields[8]);
+        if (date_format == "dd/mm/yyyy") {
+            profile.date_format = DateFormat::DayMonthYear;
+        } else if (date_format == "yyyy-mm-dd") {
+            profile.date_format = DateFormat::YearMonthDay;
+        } else {
+            throw std::runtime_error("Unknown date format in schema profile " + profile.name);
+        }
+        
+        profiles_[header_fingerprint] = std::move(profile);
+    }
+}
+
+uint64_t SchemaRegistry::fingerprint(std::string_view header_line) {
+    // Skip a UTF-8 byte order mark
+    if (header_line.substr(0, 3) == "\xEF\xBB\xBF") {
+        header_line.remove_prefix(3);
+    }
+    
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : header_line) {
+        if (c == '"' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            continue;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+const SchemaProfile* SchemaRegistry::find(uint64_t header_fingerprint) const {
+    auto it = profiles_.find(header_fingerprint);
+    return it != profiles_.end() ? &it->second : nullptr;
+}
+
+} // namespace finance
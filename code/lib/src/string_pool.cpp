@@ -0,0 +1,72 @@
+#include "string_pool.hpp"
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace finance {
+
+StringPool::StringPool() {
+    index_.emplace(std::string_view(), Symbol());
+}
+
+StringPool& StringPool::global() {
+    // Never destroyed, so symbols stay valid during static destruction too
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+Symbol StringPool::intern(std::string_view text) {
+    {
+        // Most strings repeat, so look them up under the shared lock first
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(text);
+        if (it != index_.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(text);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    if (index_.size() >= UINT32_MAX || text.size() >= UINT32_MAX) {
+        throw std::runtime_error("String pool is full");
+    }
+
+    const char* data = store(text);
+    Symbol symbol(data, static_cast<uint32_t>(text.size()),
+                  static_cast<uint32_t>(index_.size()));
+    index_.emplace(symbol.view(), symbol);
+    return symbol;
+}
+
+const char* StringPool::store(std::string_view text) {
+    bytes_used_ += text.size();
+    if (text.size() > LARGE_STRING) {
+        blocks_.emplace_back(new char[text.size()]);
+        std::memcpy(blocks_.back().get(), text.data(), text.size());
+        return blocks_.back().get();
+    }
+    if (static_cast<size_t>(block_end_ - cursor_) < text.size()) {
+        blocks_.emplace_back(new char[BLOCK_SIZE]);
+        cursor_ = blocks_.back().get();
+        block_end_ = cursor_ + BLOCK_SIZE;
+    }
+    char* data = cursor_;
+    std::memcpy(data, text.data(), text.size());
+    cursor_ += text.size();
+    return data;
+}
+
+size_t StringPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return index_.size();
+}
+
+size_t StringPool::bytesUsed() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return bytes_used_;
+}
+
+} // namespace finance
@@ -0,0 +1,471 @@
+#include "time_buckets.hpp"
+#include "hash_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace finance {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char STATE_MAGIC[8] = {'F', 'I', 'N', 'S', 'U', 'M', 'S', '1'};
+constexpr uint32_t STATE_VERSION = 1;
+
+struct StateHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t granularity_count;
+    uint64_t category_count;
+    uint64_t fingerprint;
+    uint64_t file_size;
+    uint64_t checksum;          // FNV-1a of everything after the header
+};
+
+// Category names follow the header: uint32 offsets[count + 1], then bytes,
+// padded to 8 bytes. Then one record per granularity, each followed by
+// int64 sums (pence) and uint64 row counts, [slot * span + column].
+struct StateTable {
+    uint32_t unit;
+    uint32_t first_weekday;
+    uint32_t start_month;
+    uint32_t start_day;
+    int32_t first_key;
+    uint32_t reserved;
+    uint64_t span;
+};
+
+// Zero-padded decimal of at least width digits
+std::string padded(int32_t value, size_t width) {
+    std::string digits = std::to_string(value);
+    if (digits.size() < width) {
+        digits.insert(0, width - digits.size(), '0');
+    }
+    return digits;
+}
+
+} // namespace
+
+int32_t Granularity::key(CivilDate date) const {
+    int year = 0;
+    unsigned month = 0, day = 0;
+    switch (unit) {
+    case Unit::Day:
+        return date.dayNumber();
+    case Unit::Week:
+    case Unit::IsoWeek: {
+        // Day n falls on weekday (n + 3) mod 7, so weeks starting on weekday
+        // w begin on day numbers 7 * key + w - 3
+        const int32_t first = unit == Unit::Week ? static_cast<int32_t>(first_weekday) : 0;
+        const int32_t into_week = (static_cast<int32_t>(date.weekday()) - first + 7) % 7;
+        return (date.dayNumber() - into_week - first + 3) / 7;
+    }
+    case Unit::Month:
+        return date.monthKey();
+    case Unit::Quarter:
+        date.toYmd(year, month, day);
+        return year * 4 + static_cast<int32_t>(month - 1) / 3;
+    case Unit::Year:
+        date.toYmd(year, month, day);
+        return year;
+    case Unit::FiscalYear:
+        date.toYmd(year, month, day);
+        return (month < start_month || (month == start_month && day < start_day)) ? year - 1 : year;
+    }
+    return 0;
+}
+
+std::string Granularity::label(int32_t key) const {
+    switch (unit) {
+    case Unit::Day:
+        return CivilDate::fromDayNumber(key).formatIso();
+    case Unit::Week:
+        return CivilDate::fromDayNumber(key * 7 + static_cast<int32_t>(first_weekday) - 3).formatIso();
+    case Unit::IsoWeek: {
+        // A week belongs to the ISO year holding its Thursday
+        CivilDate thursday = CivilDate::fromDayNumber(key * 7);
+        int year = 0;
+        unsigned month = 0, day = 0;
+        thursday.toYmd(year, month, day);
+        int32_t week = (thursday.dayNumber() - CivilDate::fromYmd(year, 1, 1).dayNumber()) / 7 + 1;
+        return padded(year, 4) + "-W" + padded(week, 2);
+    }
+    case Unit::Month:
+        return CivilDate::formatMonthKey(key);
+    case Unit::Quarter:
+        return padded(key / 4, 4) + "-Q" + std::to_string(key % 4 + 1);
+    case Unit::Year:
+        return padded(key, 4);
+    case Unit::FiscalYear:
+        return "FY" + padded(key, 4);
+    }
+    return std::string();
+}
+
+bool Granularity::operator==(const Granularity& other) const {
+    if (unit != other.unit) {
+        return false;
+    }
+    if (unit == Unit::Week) {
+        return first_weekday == other.first_weekday;
+    }
+    if (unit == Unit::FiscalYear) {
+        return start_month == other.start_month && start_day == other.start_day;
+    }
+    return true;
+}
+
+TimeBuckets::TimeBuckets(std::vector<Granularity> granularities) {
+    tables_.reserve(granularities.size());
+    for (const auto& granularity : granularities) {
+        tables_.emplace_back();
+        tables_.back().granularity = granularity;
+    }
+}
+
+size_t TimeBuckets::find(const Granularity& granularity) const {
+    for (size_t index = 0; index < tables_.size(); ++index) {
+        if (tables_[index].granularity == granularity) {
+            return index;
+        }
+    }
+    return NOT_FOUND;
+}
+
+void TimeBuckets::Table::grow(int32_t first, int32_t last, size_t category_count) {
+    if (span == 0) {
+        first_key = first;
+        span = static_cast<size_t>(last - first) + 1;
+        cells.assign(category_count * span, Money());
+        cell_rows.assign(category_count * span, 0);
+        period_rows.assign(span, 0);
+        return;
+    }
+
+    const int64_t old_first = first_key;
+    const int64_t old_last = first_key + static_cast<int64_t>(span) - 1;
+    if (first >= old_first && last <= old_last) {
+        return;
+    }
+
+    // Grow by at least the current span on each side that needs it, so
+    // periods arriving one at a time cost amortised constant work
+    const int64_t old_span = static_cast<int64_t>(span);
+    int64_t new_first = old_first;
+    int64_t new_last = old_last;
+    if (first < old_first) {
+        new_first = std::max<int64_t>(INT32_MIN, std::min<int64_t>(first, old_first - old_span));
+    }
+    if (last > old_last) {
+        new_last = std::min<int64_t>(INT32_MAX, std::max<int64_t>(last, old_last + old_span));
+    }
+
+    const size_t new_span = static_cast<size_t>(new_last - new_first + 1);
+    const size_t shift = static_cast<size_t>(old_first - new_first);
+    std::vector<Money> new_cells(category_count * new_span);
+    std::vector<size_t> new_cell_rows(category_count * new_span, 0);
+    for (size_t slot = 0; slot < category_count; ++slot) {
+        std::copy_n(cells.begin() + slot * span, span, new_cells.begin() + slot * new_span + shift);
+        std::copy_n(cell_rows.begin() + slot * span, span, new_cell_rows.begin() + slot * new_span + shift);
+    }
+    std::vector<size_t> new_period_rows(new_span, 0);
+    std::copy(period_rows.begin(), period_rows.end(), new_period_rows.begin() + shift);
+
+    cells = std::move(new_cells);
+    cell_rows = std::move(new_cell_rows);
+    period_rows = std::move(new_period_rows);
+    first_key = static_cast<int32_t>(new_first);
+    span = new_span;
+}
+
+void TimeBuckets::reserve(CivilDate first, CivilDate last) {
+    if (last < first) {
+        std::swap(first, last);
+    }
+    for (auto& table : tables_) {
+        table.grow(table.granularity.key(first), table.granularity.key(last), categories_.size());
+    }
+}
+
+uint32_t TimeBuckets::slot(Symbol category) {
+    auto [slot, inserted] = slots_.try_emplace(category.id(), static_cast<uint32_t>(categories_.size()));
+    if (inserted) {
+        categories_.push_back(category);
+        category_rows_.push_back(0);
+        for (auto& table : tables_) {
+            table.cells.resize(table.cells.size() + table.span);
+            table.cell_rows.resize(table.cell_rows.size() + table.span, 0);
+        }
+    }
+    return slot->second;
+}
+
+void TimeBuckets::add(const std::vector<Expense>& expenses, Symbol uncategorised) {
+    if (expenses.empty()) {
+        return;
+    }
+
+    // Size the tables for the batch's date range up front, so each add
+    // below is a single indexed write per granularity
+    auto [first, last] = std::minmax_element(expenses.begin(), expenses.end(),
+        [](const Expense& a, const Expense& b) { return a.date < b.date; });
+    reserve(first->date, last->date);
+
+    for (const auto& expense : expenses) {
+        Symbol category = expense.category.empty() ? uncategorised : expense.category;
+        add(category, expense.date, toGbp(expense.amount, expense.currency));
+    }
+}
+
+void TimeBuckets::add(Symbol category, CivilDate date, Money amount) {
+    const uint32_t row = slot(category);
+    ++category_rows_[row];
+    for (auto& table : tables_) {
+        const int32_t key = table.granularity.key(date);
+        table.grow(key, key, categories_.size());
+        const size_t column = static_cast<size_t>(key - table.first_key);
+        table.cells[row * table.span + column] += amount;
+        ++table.cell_rows[row * table.span + column];
+        ++table.period_rows[column];
+    }
+}
+
+void TimeBuckets::remove(Symbol category, CivilDate date, Money amount) {
+    auto slot = slots_.find(category.id());
+    if (slot == slots_.end() || category_rows_[slot->second] == 0) {
+        return;
+    }
+    const uint32_t row = slot->second;
+    --category_rows_[row];
+    for (auto& table : tables_) {
+        const int32_t key = table.granularity.key(date);
+        if (key < table.first_key || static_cast<size_t>(key - table.first_key) >= table.span) {
+            continue;
+        }
+        const size_t column = static_cast<size_t>(key - table.first_key);
+        table.cells[row * table.span + column] -= amount;
+        --table.cell_rows[row * table.span + column];
+        --table.period_rows[column];
+    }
+}
+
+std::vector<Symbol> TimeBuckets::categories() const {
+    std::vector<Symbol> categories;
+    for (uint32_t slot = 0; slot < categories_.size(); ++slot) {
+        if (category_rows_[slot] > 0) {
+            categories.push_back(categories_[slot]);
+        }
+    }
+    std::sort(categories.begin(), categories.end(), [](Symbol a, Symbol b) {
+        return a.view() < b.view();
+    });
+    return categories;
+}
+
+std::vector<int32_t> TimeBuckets::periods(size_t index) const {
+    const Table& table = tables_[index];
+    std::vector<int32_t> periods;
+    for (size_t column = 0; column < table.span; ++column) {
+        if (table.period_rows[column] > 0) {
+            periods.push_back(table.first_key + static_cast<int32_t>(column));
+        }
+    }
+    return periods;
+}
+
+size_t TimeBuckets::cellIndex(const Table& table, Symbol category, int32_t period) const {
+    auto slot = slots_.find(category.id());
+    if (slot == slots_.end() || period < table.first_key ||
+        static_cast<size_t>(period - table.first_key) >= table.span) {
+        return SIZE_MAX;
+    }
+    return slot->second * table.span + static_cast<size_t>(period - table.first_key);
+}
+
+Money TimeBuckets::total(size_t index, Symbol category, int32_t period) const {
+    const Table& table = tables_[index];
+    size_t cell = cellIndex(table, category, period);
+    return cell == SIZE_MAX ? Money() : table.cells[cell];
+}
+
+size_t TimeBuckets::rows(size_t index, Symbol category, int32_t period) const {
+    const Table& table = tables_[index];
+    size_t cell = cellIndex(table, category, period);
+    return cell == SIZE_MAX ? 0 : table.cell_rows[cell];
+}
+
+void TimeBuckets::save(const std::string& filepath, uint64_t fingerprint) const {
+    StateHeader header = {};
+    std::memcpy(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+    header.version = STATE_VERSION;
+    header.granularity_count = static_cast<uint32_t>(tables_.size());
+    header.category_count = categories_.size();
+    header.fingerprint = fingerprint;
+    
+    auto append = [](std::string& out, const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    };
+    
+    std::string out(sizeof(header), '\0');
+    uint32_t offset = 0;
+    append(out, &offset, sizeof(offset));
+    for (Symbol category : categories_) {
+        offset += static_cast<uint32_t>(category.size());
+        append(out, &offset, sizeof(offset));
+    }
+    for (Symbol category : categories_) {
+        out.append(category.view().data(), category.size());
+    }
+    out.resize((out.size() + 7) & ~size_t{7}, '\0');
+    
+    for (const auto& table : tables_) {
+        StateTable record = {};
+        record.unit = static_cast<uint32_t>(table.granularity.unit);
+        record.first_weekday = table.granularity.first_weekday;
+        record.start_month = table.granularity.start_month;
+        record.start_day = table.granularity.start_day;
+        record.first_key = table.first_key;
+        record.span = table.span;
+        append(out, &record, sizeof(record));
+        for (Money sum : table.cells) {
+            int64_t minor = sum.minorUnits();
+            append(out, &minor, sizeof(minor));
+        }
+        for (size_t rows : table.cell_rows) {
+            uint64_t count = rows;
+            append(out, &count, sizeof(count));
+        }
+    }
+    header.file_size = out.size();
+    header.checksum = fnv1a64(std::string_view(out).substr(sizeof(header)));
+    std::memcpy(&out[0], &header, sizeof(header));
+    
+    // Write to a temporary file first so a crash never leaves torn totals
+    std::string temp_path = filepath + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temp_path);
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    fs::rename(temp_path, filepath);
+}
+
+bool TimeBuckets::load(const std::string& filepath, uint64_t fingerprint) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    StateHeader header;
+    if (bytes.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC)) != 0 ||
+        header.version != STATE_VERSION ||
+        header.fingerprint != fingerprint ||
+        header.file_size != bytes.size() ||
+        header.category_count >= UINT32_MAX ||
+        fnv1a64(std::string_view(bytes).substr(sizeof(header))) != header.checksum) {
+        return false;
+    }
+    
+    // Category names
+    size_t position = sizeof(header);
+    const size_t offsets_bytes = sizeof(uint32_t) * (header.category_count + 1);
+    if (offsets_bytes > bytes.size() - position) {
+        return false;
+    }
+    const size_t names_begin = position + offsets_bytes;
+    std::vector<Symbol> categories;
+    for (size_t i = 0; i < header.category_count; ++i) {
+        uint32_t begin, end;
+        std::memcpy(&begin, bytes.data() + position + sizeof(uint32_t) * i, sizeof(begin));
+        std::memcpy(&end, bytes.data() + position + sizeof(uint32_t) * (i + 1), sizeof(end));
+        if (begin > end || end > bytes.size() - names_begin) {
+            return false;
+        }
+        categories.push_back(Symbol::intern(std::string_view(bytes.data() + names_begin + begin, end - begin)));
+    }
+    uint32_t names_size = 0;
+    std::memcpy(&names_size, bytes.data() + position + sizeof(uint32_t) * header.category_count, sizeof(names_size));
+    if (names_size > bytes.size() - names_begin) {
+        return false;
+    }
+    position = (names_begin + names_size + 7) & ~size_t{7};
+    
+    std::unordered_map<uint32_t, uint32_t> slots;
+    for (uint32_t slot = 0; slot < categories.size(); ++slot) {
+        if (!slots.emplace(categories[slot].id(), slot).second) {
+            return false;
+        }
+    }
+    
+    // Tables
+    const size_t category_count = categories.size();
+    std::vector<Table> tables(header.granularity_count);
+    for (auto& table : tables) {
+        StateTable record;
+        if (position > bytes.size() || sizeof(record) > bytes.size() - position) {
+            return false;
+        }
+        std::memcpy(&record, bytes.data() + position, sizeof(record));
+        position += sizeof(record);
+        
+        const size_t cell_bytes = 2 * sizeof(uint64_t);
+        if (record.unit > static_cast<uint32_t>(Granularity::Unit::FiscalYear) ||
+            record.span > UINT32_MAX ||
+            record.first_key + static_cast<int64_t>(record.span) - 1 > INT32_MAX ||
+            (category_count > 0 && record.span > (bytes.size() - position) / cell_bytes / category_count)) {
+            return false;
+        }
+        table.granularity = {static_cast<Granularity::Unit>(record.unit), record.first_weekday,
+                             record.start_month, record.start_day};
+        table.first_key = record.first_key;
+        table.span = static_cast<size_t>(record.span);
+        
+        const size_t cell_count = category_count * table.span;
+        table.cells.resize(cell_count);
+        table.cell_rows.resize(cell_count);
+        table.period_rows.assign(table.span, 0);
+        for (size_t cell = 0; cell < cell_count; ++cell) {
+            int64_t minor;
+            std::memcpy(&minor, bytes.data() + position + sizeof(minor) * cell, sizeof(minor));
+            table.cells[cell] = Money::fromMinor(minor);
+        }
+        position += sizeof(int64_t) * cell_count;
+        for (size_t cell = 0; cell < cell_count; ++cell) {
+            uint64_t count;
+            std::memcpy(&count, bytes.data() + position + sizeof(count) * cell, sizeof(count));
+            table.cell_rows[cell] = static_cast<size_t>(count);
+            table.period_rows[cell % table.span] += table.cell_rows[cell];
+        }
+        position += sizeof(uint64_t) * cell_count;
+    }
+    if (position != bytes.size()) {
+        return false;
+    }
+    
+    // Every table holds the same rows, so any of them gives the category counts
+    std::vector<size_t> category_rows(category_count, 0);
+    if (!tables.empty()) {
+        for (size_t cell = 0; cell < tables[0].cell_rows.size(); ++cell) {
+            category_rows[cell / tables[0].span] += tables[0].cell_rows[cell];
+        }
+    }
+    
+    tables_ = std::move(tables);
+    categories_ = std::move(categories);
+    category_rows_ = std::move(category_rows);
+    slots_ = std::move(slots);
+    return true;
+}
+
+} // namespace finance
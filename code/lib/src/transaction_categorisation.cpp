@@ -1,63 +1,183 @@
 #include "transaction_categorisation.hpp"
+#include "parallel_for.hpp"
+#include "rule_stats.hpp"
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 
 namespace finance {
 
 TransactionCategorisation::TransactionCategorisation(
     const std::map<std::string, std::string>& keyword_map)
-    : keyword_map_(keyword_map) {}
+    : matcher_(keyword_map)
+    , rules_fingerprint_(keywordRulesFingerprint(keyword_map))
+    , credit_card_(Symbol::intern("Credit card"))
+    , uncategorised_(Symbol::intern("Uncategorised")) {
+    keywords_.reserve(keyword_map.size());
+    for (const auto& entry : keyword_map) {
+        keywords_.push_back(entry.first);
+    }
+}
+
+TransactionCategorisation::TransactionCategorisation(std::shared_ptr<const RulePack> rules)
+    : rules_(std::move(rules))
+    , matcher_(rules_->matcher())
+    , rules_fingerprint_(rules_->rulesFingerprint())
+    , credit_card_(Symbol::intern("Credit card"))
+    , uncategorised_(Symbol::intern("Uncategorised")) {}
+
+void TransactionCategorisation::setMemo(CategoryMemo* memo) {
+    memo_ = memo;
+}
+
+void TransactionCategorisation::setRuleStats(RuleStats* rule_stats) {
+    rule_stats_ = rule_stats;
+}
 
 void TransactionCategorisation::categoriseExpense(Expense& expense) const {
+    CategorisationStats stats;
+    if (!rule_stats_) {
+        categorise(expense, stats);
+        return;
+    }
+    CategoryDecision decision;
+    categorise(expense, stats, &decision);
+    rule_stats_->record(decision, expense);
+}
+
+void TransactionCategorisation::categorise(Expense& expense, CategorisationStats& stats,
+                                           CategoryDecision* decision_out) const {
+    // Merchants seen before (this run or an earlier one) skip matching,
+    // unless the deciding rule is wanted
+    CategoryMemo::Entry memoised;
+    if (memo_ && !decision_out && memo_->find(expense.description.view(), expense.name.view(), memoised)) {
+        if (memoised.invert_amount) {
+            expense.amount = -expense.amount;
+            ++stats.inverted;
+        }
+        expense.category = memoised.category;
+        ++stats.memo_hits;
+        ++(expense.category == uncategorised_ ? stats.uncategorised : stats.matched);
+        return;
+    }
+    
+    CategoryDecision decision = decideCategory(expense);
+    if (decision.inverted) {
+        ++stats.inverted;
+    }
+    ++(expense.category == uncategorised_ ? stats.uncategorised : stats.matched);
+    
+    if (memo_) {
+        memo_->insert(expense.description.view(), expense.name.view(),
+                      expense.category, decision.inverted);
+    }
+    if (decision_out) {
+        *decision_out = decision;
+    }
+}
+
+CategoryDecision TransactionCategorisation::decideCategory(Expense& expense) const {
+    CategoryDecision decision;
+    
     // Find matching category based on description
-    std::string category = findMatchingCategory(expense.description);
+    uint32_t rule = findMatchingRule(expense.description.view());
     
     // If no match found and name is available, try matching on name
-    if (category.empty() && !expense.name.empty()) {
-        category = findMatchingCategory(expense.name);
+    if (rule == KeywordMatcher::NO_MATCH && !expense.name.empty()) {
+        rule = findMatchingRule(expense.name.view());
+        decision.by_name = rule != KeywordMatcher::NO_MATCH;
+    }
+    
+    Symbol category;
+    if (rule != KeywordMatcher::NO_MATCH) {
+        decision.rule = rule;
+        category = matcher_.category(rule);
     }
     
     // Handle credit card repayments
-    if (category == "Credit card") {
-        std::string lower_desc = toLower(expense.description);
+    if (category == credit_card_) {
+        std::string lower_desc = toLower(expense.description.view());
         if (lower_desc.find("amex") != std::string::npos || 
             lower_desc.find("payment received") != std::string::npos) {
             // Invert the amount for credit card repayments
+            decision.inverted = true;
             expense.amount = -expense.amount;
         }
     }
     
     // Set the category (use "Uncategorised" if no match found)
-    expense.category = category.empty() ? "Uncategorised" : category;
+    expense.category = category.empty() ? uncategorised_ : category;
+    return decision;
 }
 
 void TransactionCategorisation::categoriseExpenses(
     std::vector<Expense>& expenses) const {
+    if (!rule_stats_) {
+        for (auto& expense : expenses) {
+            categoriseExpense(expense);
+        }
+        return;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
     for (auto& expense : expenses) {
         categoriseExpense(expense);
     }
+    rule_stats_->addMatchTime(std::chrono::steady_clock::now() - start);
+}
+
+CategorisationStats TransactionCategorisation::categoriseExpenses(
+    std::vector<Expense>& expenses, size_t thread_count) const {
+    // A few shards per thread so uneven rows balance out, but none so small
+    // that scheduling costs more than matching
+    constexpr size_t MIN_SHARD_ROWS = 2048;
+    size_t threads = thread_count == 0 ? defaultThreadCount() : thread_count;
+    size_t shard_count = std::max<size_t>(
+        1, std::min(threads * 4, expenses.size() / MIN_SHARD_ROWS));
+    size_t shard_rows = (expenses.size() + shard_count - 1) / shard_count;
+    
+    // Each shard counts into its own slot; merged once all are done. Deciding
+    // rules, when wanted, are kept per row and counted afterwards in row order.
+    std::vector<CategorisationStats> shard_stats(shard_count);
+    std::vector<CategoryDecision> decisions(rule_stats_ ? expenses.size() : 0);
+    auto start = std::chrono::steady_clock::now();
+    parallelFor(shard_count, threads, [&](size_t shard) {
+        size_t end = std::min(expenses.size(), (shard + 1) * shard_rows);
+        for (size_t i = shard * shard_rows; i < end; ++i) {
+            categorise(expenses[i], shard_stats[shard],
+                       decisions.empty() ? nullptr : &decisions[i]);
+        }
+    });
+    if (rule_stats_) {
+        rule_stats_->addMatchTime(std::chrono::steady_clock::now() - start);
+        for (size_t i = 0; i < expenses.size(); ++i) {
+            rule_stats_->record(decisions[i], expenses[i]);
+        }
+    }
+    
+    CategorisationStats stats;
+    for (const auto& shard : shard_stats) {
+        stats += shard;
+    }
+    return stats;
 }
 
-std::string TransactionCategorisation::toLower(const std::string& str) {
-    std::string lower = str;
+std::string TransactionCategorisation::toLower(std::string_view str) {
+    std::string lower(str);
     std::transform(lower.begin(), lower.end(), lower.begin(), 
                   [](unsigned char c) { return std::tolower(c); });
     return lower;
 }
 
-std::string TransactionCategorisation::findMatchingCategory(
-    const std::string& description) const {
-    // Convert description to lowercase for case-insensitive matching
-    std::string lower_desc = toLower(description);
-    
-    // Check each keyword
-    for (const auto& [keyword, category] : keyword_map_) {
-        if (lower_desc.find(toLower(keyword)) != std::string::npos) {
-            return category;
-        }
+uint32_t TransactionCategorisation::findMatchingRule(
+    std::string_view description) const {
+    // Single case-insensitive scan for every keyword; the first keyword in
+    // map order that occurs in the description decides the category
+    uint32_t rule = matcher_.findRank(description);
+    if (rule != KeywordMatcher::NO_MATCH && matcher_.category(rule).empty()) {
+        return KeywordMatcher::NO_MATCH;  // An empty category counts as no match
     }
-    
-    return "";  // No match found
+    return rule;
 }
 
 } // namespace finance 
\ No newline at end of file
@@ -1,113 +1,242 @@
 #include "transaction_parser.hpp"
-#include <sstream>
-#include <iomanip>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
-#include <regex>
+#include <stdexcept>
 
 namespace finance {
 
-using TimePoint = std::chrono::system_clock::time_point;
+namespace {
 
-TimePoint TransactionParser::parseDate(
-    const std::string& date_str) {
-    std::istringstream ss(date_str);
-    std::tm tm = {};  // Zero-initialize
-    
-    // Parse date using format specifier
-    ss >> std::get_time(&tm, "%d/%m/%Y");
-    
-    if (ss.fail()) {
-        throw std::runtime_error("Failed to parse date: " + date_str);
+// Word characters as matched by a regex \w in the classic locale
+inline bool isWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+// Whitespace as matched by a regex \s in the classic locale
+inline bool isSpaceChar(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Currency for a whole word equal to GBR, GBP, EUR or USD, else UNKNOWN
+inline Currency currencyCodeOf(const char* word, size_t length) {
+    if (length != 3) return Currency::UNKNOWN;
+    if (std::memcmp(word, "GBR", 3) == 0 || std::memcmp(word, "GBP", 3) == 0) return Currency::GBP;
+    if (std::memcmp(word, "EUR", 3) == 0) return Currency::EUR;
+    if (std::memcmp(word, "USD", 3) == 0) return Currency::USD;
+    return Currency::UNKNOWN;
+}
+
+} // namespace
+
+Currency TransactionParser::normaliseDescription(std::string_view raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+    
+    Currency currency = Currency::UNKNOWN;
+    bool pending_space = false;  // Whitespace seen since the last emitted char
+    bool in_word = false;
+    size_t word_mark = 0;        // Output size before the current word
+    bool word_pending = false;   // pending_space when the current word began
+    size_t word_length = 0;
+    
+    auto emit = [&](char c) {
+        if (pending_space && !out.empty()) {
+            out += ' ';
+        }
+        pending_space = false;
+        out += c;
+    };
+    
+    // A word that is exactly a currency code is dropped along with the space
+    // that would have preceded it; the first one sets the currency
+    auto finishWord = [&]() {
+        in_word = false;
+        Currency code = currencyCodeOf(out.data() + out.size() - word_length, word_length);
+        if (code == Currency::UNKNOWN) {
+            return;
+        }
+        if (currency == Currency::UNKNOWN) {
+            currency = code;
+        }
+        out.resize(word_mark);
+        pending_space = word_pending;
+    };
+    
+    for (char c : raw) {
+        // Everything after the first comma is dropped
+        if (c == ',') break;
+        if (c == '"') continue;
+        
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (isWordChar(uc)) {
+            if (!in_word) {
+                in_word = true;
+                word_mark = out.size();
+                word_pending = pending_space;
+                word_length = 0;
+            }
+            emit(c);
+            ++word_length;
+            continue;
+        }
+        
+        if (in_word) {
+            finishWord();
+        }
+        if (isSpaceChar(uc)) {
+            pending_space = true;
+        } else {
+            emit(c);
+        }
+    }
+    if (in_word) {
+        finishWord();
     }
     
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    return currency;
 }
 
-std::string TransactionParser::extractMonth(
-    const std::chrono::system_clock::time_point& date) {
-    auto time = std::chrono::system_clock::to_time_t(date);
-    std::tm tm = *std::localtime(&time);
-    char buffer[8];
-    std::strftime(buffer, sizeof(buffer), "%Y-%m", &tm);
-    return std::string(buffer);
+Currency TransactionParser::normaliseDescription(std::string_view raw, Symbol& out) {
+    // Reuse one buffer per thread; only new descriptions are copied
+    thread_local std::string normalised;
+    Currency currency = normaliseDescription(raw, normalised);
+    out = Symbol::intern(normalised);
+    return currency;
 }
 
-Currency TransactionParser::parseCurrencyType(const std::string& amount_str) {
-    // Look for currency symbols at the start or end of the string
-    std::string str = amount_str;
-    str.erase(std::remove_if(str.begin(), str.end(), ::isspace), str.end());
+size_t TransactionParser::removeCurrencyCodes(char* str, size_t length) {
+    // Compact in place, skipping whole words that are currency codes
+    size_t write = 0;
+    size_t read = 0;
+    while (read < length) {
+        if (!isWordChar(static_cast<unsigned char>(str[read]))) {
+            str[write++] = str[read++];
+            continue;
+        }
+        
+        size_t word_start = read;
+        while (read < length && isWordChar(static_cast<unsigned char>(str[read]))) {
+            ++read;
+        }
+        if (currencyCodeOf(str + word_start, read - word_start) == Currency::UNKNOWN) {
+            std::memmove(str + write, str + word_start, read - word_start);
+            write += read - word_start;
+        }
+    }
+    return write;
+}
+
+CivilDate TransactionParser::parseDate(std::string_view date_str, DateFormat format) {
+    size_t pos = 0;
+    while (pos < date_str.size() && (date_str[pos] == ' ' || date_str[pos] == '\t')) {
+        ++pos;
+    }
     
-    if (str.find("£") != std::string::npos) return Currency::GBP;
-    if (str.find("€") != std::string::npos) return Currency::EUR;
-    if (str.find("$") != std::string::npos) return Currency::USD;
+    // Read between 1 and max_digits decimal digits
+    auto readNumber = [&](size_t max_digits, unsigned& value) {
+        size_t start = pos;
+        value = 0;
+        while (pos < date_str.size() && pos - start < max_digits &&
+               date_str[pos] >= '0' && date_str[pos] <= '9') {
+            value = value * 10 + static_cast<unsigned>(date_str[pos] - '0');
+            ++pos;
+        }
+        return pos > start;
+    };
+    auto readSeparator = [&](char separator) {
+        return pos < date_str.size() && date_str[pos++] == separator;
+    };
+    
+    unsigned day = 0, month = 0, year = 0;
+    bool valid = format == DateFormat::YearMonthDay
+        ? readNumber(4, year) && readSeparator('-') &&
+          readNumber(2, month) && readSeparator('-') && readNumber(2, day)
+        : readNumber(2, day) && readSeparator('/') &&
+          readNumber(2, month) && readSeparator('/') && readNumber(4, year);
+    if (!valid || day < 1 || day > 31 || month < 1 || month > 12) {
+        throw std::runtime_error("Failed to parse date: " + std::string(date_str));
+    }
+    
+    return CivilDate::fromYmd(static_cast<int>(year), month, day);
+}
+
+Currency TransactionParser::parseCurrencyType(std::string_view str) {
+    // Look for currency symbols anywhere in the (whitespace-free) amount
+    if (str.find("£") != std::string_view::npos) return Currency::GBP;
+    if (str.find("€") != std::string_view::npos) return Currency::EUR;
+    if (str.find("$") != std::string_view::npos) return Currency::USD;
     
     // Look for currency codes
-    if (str.find("GBP") != std::string::npos || str.find("GBR") != std::string::npos) return Currency::GBP;
-    if (str.find("EUR") != std::string::npos) return Currency::EUR;
-    if (str.find("USD") != std::string::npos) return Currency::USD;
+    if (str.find("GBP") != std::string_view::npos || str.find("GBR") != std::string_view::npos) return Currency::GBP;
+    if (str.find("EUR") != std::string_view::npos) return Currency::EUR;
+    if (str.find("USD") != std::string_view::npos) return Currency::USD;
     
     return Currency::GBP;
 }
 
-std::pair<double, Currency> TransactionParser::parseAmount(const std::string& amount_str) {
-    // First parse the currency type
-    Currency currency = parseCurrencyType(amount_str);
+std::pair<Money, Currency> TransactionParser::parseAmount(std::string_view amount_str) {
+    // Amount fields are short; only unusually long ones need the heap
+    char stack_buffer[64];
+    std::string heap_buffer;
+    char* buffer = stack_buffer;
+    if (amount_str.size() > sizeof(stack_buffer)) {
+        heap_buffer.resize(amount_str.size());
+        buffer = &heap_buffer[0];
+    }
     
-    // Remove currency symbols and clean numeric formatting
-    std::string cleaned = removeNumericFormatting(removeCurrencySymbols(amount_str));
+    // Drop whitespace, then detect the currency
+    size_t length = 0;
+    for (char c : amount_str) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            buffer[length++] = c;
+        }
+    }
+    Currency currency = parseCurrencyType(std::string_view(buffer, length));
+    
+    // Strip currency symbols, then whole-word currency codes, then quotes
+    // and thousands separators, compacting in place
+    auto symbolAt = [&](size_t pos, const char* symbol) {
+        size_t symbol_length = strlen(symbol);
+        return pos + symbol_length <= length &&
+               std::memcmp(buffer + pos, symbol, symbol_length) == 0;
+    };
+    size_t write = 0;
+    for (size_t read = 0; read < length; ++read) {
+        if (buffer[read] == '$') continue;
+        if (symbolAt(read, "£")) {
+            read += strlen("£") - 1;
+            continue;
+        }
+        if (symbolAt(read, "€")) {
+            read += strlen("€") - 1;
+            continue;
+        }
+        buffer[write++] = buffer[read];
+    }
+    length = removeCurrencyCodes(buffer, write);
+    write = 0;
+    for (size_t read = 0; read < length; ++read) {
+        if (buffer[read] != '"' && buffer[read] != ',') {
+            buffer[write++] = buffer[read];
+        }
+    }
+    std::string_view cleaned(buffer, write);
     
     // Handle empty or invalid strings
     if (cleaned.empty() || cleaned == "-") {
-        return {0.0, currency};
+        return {Money(), currency};
     }
     
-    try {
-        double amount = std::stod(cleaned);
-        return {amount, currency};
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to parse amount: " << amount_str 
+    Money amount;
+    if (!Money::parse(cleaned, amount)) {
+        std::cerr << "Failed to parse amount: " << amount_str
                   << " (cleaned: " << cleaned << ")" << std::endl;
-        return {0.0, Currency::UNKNOWN};
-    }
-}
-
-std::string TransactionParser::removeCurrencySymbols(const std::string& amount_str) {
-    std::string cleaned = amount_str;
-    
-    // Remove single-byte currency symbols and whitespace
-    cleaned.erase(std::remove_if(cleaned.begin(), cleaned.end(),
-        [](unsigned char c) { return c == '$' || std::isspace(c); }),
-        cleaned.end());
-    
-    // Remove multi-byte currency symbols
-    size_t pos;
-    while ((pos = cleaned.find("£")) != std::string::npos) {
-        cleaned.erase(pos, strlen("£"));
+        return {Money(), Currency::UNKNOWN};
     }
-    while ((pos = cleaned.find("€")) != std::string::npos) {
-        cleaned.erase(pos, strlen("€"));
-    }
-    
-    // Remove currency codes
-    std::regex currency_code(R"(\b(GBP|GBR|EUR|USD)\b)");
-    cleaned = std::regex_replace(cleaned, currency_code, "");
-    
-    return cleaned;
-}
-
-std::string TransactionParser::removeNumericFormatting(const std::string& amount_str) {
-    std::string cleaned = amount_str;
-    
-    // Remove quotes that might enclose the amount
-    cleaned.erase(std::remove(cleaned.begin(), cleaned.end(), '"'),
-                 cleaned.end());
-    
-    // Remove thousands separators (commas)
-    cleaned.erase(std::remove(cleaned.begin(), cleaned.end(), ','),
-                 cleaned.end());
-    
-    return cleaned;
+    return {amount, currency};
 }
 
 } // namespace finance 
\ No newline at end of file